@@ -5,6 +5,8 @@
 // The sonic game does not need blending so only the binary blending mode is implemented.
 #pragma once
 #include <primitive>
+#include <algorithm>
+#include <span>
 
 namespace draw {
     struct Color final {
@@ -73,21 +75,97 @@ namespace draw {
             return top.a == 255 ? top : bottom;
         }
 
+        /// Divides by 255, truncating, without a division. Exact for every product of two bytes.
+        [[clang::always_inline]] [[gnu::const]]
+        constexpr auto div255(u32 value) noexcept -> u32 {
+            return (value + 1 + (value >> 8)) >> 8;
+        }
+
         /// Alpha blending, not intended for use by the game since the original hardware didn't support
         /// transparency, however it could be useful for transparent debug overlays.
         [[clang::always_inline]] [[gnu::const]]
         constexpr auto alpha(Color top, Color bottom) noexcept -> Color {
-            const i32 tr = top.r, tg = top.g, tb = top.b, ta = top.a;
-            const i32 br = bottom.r, bg = bottom.g, bb = bottom.b, ba = bottom.a;
-            const i32 inv_a = 255 - ta;
+            const u32 tr = top.r, tg = top.g, tb = top.b, ta = top.a;
+            const u32 br = bottom.r, bg = bottom.g, bb = bottom.b, ba = bottom.a;
+            const u32 inv_a = 255 - ta;
 
             return Color::rgba(
-                (tr * ta + br * inv_a) / 255,
-                (tg * ta + bg * inv_a) / 255,
-                (tb * ta + bb * inv_a) / 255,
-                (ta + (ba * inv_a) / 255)
+                div255(tr * ta + br * inv_a),
+                div255(tg * ta + bg * inv_a),
+                div255(tb * ta + bb * inv_a),
+                ta + div255(ba * inv_a)
             );
         }
+
+        /// Alpha blending of a top color whose channels were already multiplied by its alpha,
+        /// which saves a multiplication per channel.
+        [[clang::always_inline]] [[gnu::const]]
+        constexpr auto premultiplied(Color top, Color bottom) noexcept -> Color {
+            const u32 inv_a = 255 - top.a;
+            return Color::rgba(
+                top.r + div255(bottom.r * inv_a),
+                top.g + div255(bottom.g * inv_a),
+                top.b + div255(bottom.b * inv_a),
+                top.a + div255(bottom.a * inv_a)
+            );
+        }
+
+        /// The blend modes applied to whole rows, `top` over `bottom` into `bottom`.
+        ///
+        /// Results are identical to the per pixel functions. The loops work on plain bytes without
+        /// branches or divisions so the compiler vectorizes them for whatever the target offers,
+        /// SSE, AVX2 or NEON, and falls back to scalar code elsewhere.
+        namespace rows {
+            static_assert(sizeof(Color) == 4 and alignof(Color) == 1);
+
+            inline void overwrite(std::span<const Color> top, std::span<Color> bottom) noexcept {
+                std::copy_n(top.begin(), std::min(top.size(), bottom.size()), bottom.begin());
+            }
+
+            inline void binary(std::span<const Color> top, std::span<Color> bottom) noexcept {
+                const usize count = std::min(top.size(), bottom.size());
+                u8 const* __restrict src = (u8 const*) top.data();
+                u8* __restrict dst = (u8*) bottom.data();
+
+                for (usize i = 0; i < count * 4; i += 4) {
+                    const bool opaque = src[i + 3] == 255;
+                    for (usize c = 0; c < 4; c += 1) dst[i + c] = opaque ? src[i + c] : dst[i + c];
+                }
+            }
+
+            inline void alpha(std::span<const Color> top, std::span<Color> bottom) noexcept {
+                const usize count = std::min(top.size(), bottom.size());
+                u8 const* __restrict src = (u8 const*) top.data();
+                u8* __restrict dst = (u8*) bottom.data();
+
+                for (usize i = 0; i < count * 4; i += 4) {
+                    const u32 a = src[i + 3];
+                    const u32 inv_a = 255 - a;
+                    for (usize c = 0; c < 3; c += 1) dst[i + c] = u8(div255(src[i + c] * a + dst[i + c] * inv_a));
+                    dst[i + 3] = u8(a + div255(dst[i + 3] * inv_a));
+                }
+            }
+
+            inline void premultiplied(std::span<const Color> top, std::span<Color> bottom) noexcept {
+                const usize count = std::min(top.size(), bottom.size());
+                u8 const* __restrict src = (u8 const*) top.data();
+                u8* __restrict dst = (u8*) bottom.data();
+
+                for (usize i = 0; i < count * 4; i += 4) {
+                    const u32 inv_a = 255 - src[i + 3];
+                    for (usize c = 0; c < 4; c += 1) dst[i + c] = u8(src[i + c] + div255(dst[i + c] * inv_a));
+                }
+            }
+
+            /// Picks the row kernel matching a per pixel blend function, if there is one.
+            inline auto of(Color (*blend)(Color, Color) noexcept) noexcept -> void (*)(std::span<const Color>, std::span<Color>) noexcept {
+                if (blend == &blend::overwrite) return &rows::overwrite;
+                if (blend == &blend::binary) return &rows::binary;
+                if (blend == &blend::alpha) return &rows::alpha;
+                if (blend == &blend::premultiplied) return &rows::premultiplied;
+                return nullptr;
+            }
+        }
     }
 
     namespace color {
@@ -0,0 +1,201 @@
+// Image encoders.
+//
+// These turn any sized plane into the bytes of an image file. They are pure, writing the result out
+// is left to Io or to something like the rt::SequenceWriter which does it off the rendering threads.
+#pragma once
+#include <primitive>
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "color.hpp"
+#include "plane.hpp"
+
+namespace draw::encode {
+    enum class Format {
+        /// Uncompressed 32-bit TGA, the fastest to encode.
+        Tga,
+        /// Run-length encoded 32-bit TGA.
+        TgaRle,
+        /// Binary PPM, alpha is discarded.
+        Ppm,
+        /// The Quite OK Image format, lossless and considerably smaller at a small encoding cost.
+        Qoi,
+    };
+
+    constexpr auto extension(Format format) noexcept -> std::string_view {
+        switch (format) {
+            case Format::Tga:
+            case Format::TgaRle: return "tga";
+            case Format::Ppm:    return "ppm";
+            case Format::Qoi:    return "qoi";
+        }
+        return "";
+    }
+
+    /// Encodes a TGA with the origin in the top left, which is how it's read back by TgaImage.
+    template <SizedPlane T> auto tga(T const& plane, bool rle = false) -> std::vector<u8> {
+        const i32 w = plane.width();
+        const i32 h = plane.height();
+
+        std::vector<u8> out;
+        out.reserve(18 + usize(w) * usize(h) * 4);
+        const u8 header[18] {
+            0, 0, u8(rle ? 10 : 2), 0, 0, 0, 0, 0, 0, 0, 0, 0,
+            u8(w), u8(w >> 8), u8(h), u8(h >> 8), 32, 0x28,
+        };
+        out.insert(out.end(), header, header + sizeof(header));
+
+        const auto push = [&out] (Color c) {
+            const u8 bgra[4] { c.b, c.g, c.r, c.a };
+            out.insert(out.end(), bgra, bgra + 4);
+        };
+
+        for (i32 y = 0; y < h; y += 1) {
+            if (not rle) {
+                for (i32 x = 0; x < w; x += 1) push(plane.get(x, y));
+                continue;
+            }
+
+            // Packets don't cross rows, some readers don't expect them to.
+            i32 x = 0;
+            while (x < w) {
+                const Color first = plane.get(x, y);
+                i32 run = 1;
+                while (x + run < w and run < 128 and plane.get(x + run, y) == first) run += 1;
+
+                if (run > 1) {
+                    out.push_back(u8(0x80 | (run - 1)));
+                    push(first);
+                    x += run;
+                    continue;
+                }
+
+                // Gather literals until the next run of at least two.
+                i32 count = 1;
+                while (x + count < w and count < 128 and plane.get(x + count, y) != plane.get(x + count - 1, y)) count += 1;
+                if (x + count < w and count > 1) count -= 1;
+
+                out.push_back(u8(count - 1));
+                for (i32 i = 0; i < count; i += 1) push(plane.get(x + i, y));
+                x += count;
+            }
+        }
+
+        return out;
+    }
+
+    /// Encodes a binary (P6) PPM.
+    template <SizedPlane T> auto ppm(T const& plane) -> std::vector<u8> {
+        const i32 w = plane.width();
+        const i32 h = plane.height();
+        const auto header = "P6\n" + std::to_string(w) + " " + std::to_string(h) + "\n255\n";
+
+        std::vector<u8> out;
+        out.reserve(header.size() + usize(w) * usize(h) * 3);
+        out.insert(out.end(), header.begin(), header.end());
+
+        for (i32 y = 0; y < h; y += 1) {
+            for (i32 x = 0; x < w; x += 1) {
+                const Color c = plane.get(x, y);
+                const u8 rgb[3] { c.r, c.g, c.b };
+                out.insert(out.end(), rgb, rgb + 3);
+            }
+        }
+
+        return out;
+    }
+
+    /// Encodes a QOI image with four channels in the sRGB color space.
+    template <SizedPlane T> auto qoi(T const& plane) -> std::vector<u8> {
+        const u32 w = u32(plane.width());
+        const u32 h = u32(plane.height());
+
+        std::vector<u8> out;
+        out.reserve(14 + usize(w) * usize(h) + 8);
+
+        const auto be32 = [&out] (u32 value) {
+            const u8 bytes[4] { u8(value >> 24), u8(value >> 16), u8(value >> 8), u8(value) };
+            out.insert(out.end(), bytes, bytes + 4);
+        };
+
+        const u8 magic[4] { 'q', 'o', 'i', 'f' };
+        out.insert(out.end(), magic, magic + 4);
+        be32(w);
+        be32(h);
+        out.push_back(4); // channels
+        out.push_back(0); // sRGB
+
+        std::array<Color, 64> seen {};
+        Color previous = Color::rgba(0, 0, 0, 255);
+        u8 run = 0;
+
+        const auto hash = [] (Color c) -> usize {
+            return (c.r * 3 + c.g * 5 + c.b * 7 + c.a * 11) % 64;
+        };
+
+        for (u32 y = 0; y < h; y += 1) {
+            for (u32 x = 0; x < w; x += 1) {
+                const Color c = plane.get(i32(x), i32(y));
+
+                if (c == previous) {
+                    run += 1;
+                    if (run == 62 or (x == w - 1 and y == h - 1)) {
+                        out.push_back(u8(0xC0 | (run - 1)));
+                        run = 0;
+                    }
+                    continue;
+                }
+
+                if (run > 0) {
+                    out.push_back(u8(0xC0 | (run - 1)));
+                    run = 0;
+                }
+
+                const usize index = hash(c);
+                if (seen[index] == c) {
+                    out.push_back(u8(index));
+                } else {
+                    seen[index] = c;
+
+                    if (c.a == previous.a) {
+                        const i8 dr = i8(c.r - previous.r);
+                        const i8 dg = i8(c.g - previous.g);
+                        const i8 db = i8(c.b - previous.b);
+                        const i8 dr_dg = i8(dr - dg);
+                        const i8 db_dg = i8(db - dg);
+
+                        if (dr >= -2 and dr <= 1 and dg >= -2 and dg <= 1 and db >= -2 and db <= 1) {
+                            out.push_back(u8(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+                        } else if (dg >= -32 and dg <= 31 and dr_dg >= -8 and dr_dg <= 7 and db_dg >= -8 and db_dg <= 7) {
+                            out.push_back(u8(0x80 | (dg + 32)));
+                            out.push_back(u8((dr_dg + 8) << 4 | (db_dg + 8)));
+                        } else {
+                            const u8 rgb[4] { 0xFE, c.r, c.g, c.b };
+                            out.insert(out.end(), rgb, rgb + 4);
+                        }
+                    } else {
+                        const u8 rgba[5] { 0xFF, c.r, c.g, c.b, c.a };
+                        out.insert(out.end(), rgba, rgba + 5);
+                    }
+                }
+
+                previous = c;
+            }
+        }
+
+        const u8 end[8] { 0, 0, 0, 0, 0, 0, 0, 1 };
+        out.insert(out.end(), end, end + 8);
+        return out;
+    }
+
+    template <SizedPlane T> auto encode(Format format, T const& plane) -> std::vector<u8> {
+        switch (format) {
+            case Format::Tga:    return tga(plane);
+            case Format::TgaRle: return tga(plane, true);
+            case Format::Ppm:    return ppm(plane);
+            case Format::Qoi:    return qoi(plane);
+        }
+        return {};
+    }
+}
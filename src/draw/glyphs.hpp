@@ -0,0 +1,188 @@
+// A process wide atlas of rasterized glyphs shared by all text drawn through it.
+//
+// A Text plane rasterizes its whole string on first use and throws it away together with the plane,
+// so lines rebuilt every frame look up, slice and recolor every glyph every frame. The cache keeps each
+// glyph of a font in a given color once instead, packed into shelves of a single atlas image, and text
+// is drawn by blending rows of the atlas straight into the target.
+#pragma once
+#include <primitive>
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include "color.hpp"
+#include "plane.hpp"
+#include "image.hpp"
+#include "text.hpp"
+
+namespace draw {
+    /// Caches glyphs by font, character and color.
+    ///
+    /// Fonts are told apart by their address, which is fine for the fonts handed out by reference from
+    /// static storage but means a font must not be a temporary.
+    class GlyphCache final {
+      public:
+        struct Glyph final {
+            /// Where the glyph is in the atlas, empty for spaces.
+            Image::Region region;
+            i32 width;
+            /// Spaces advance by their width alone, glyphs by their width and the font spacing.
+            bool space;
+        };
+
+      private:
+        struct Key final {
+            void const* font;
+            u32 character;
+            Color color;
+
+            auto operator==(Key const&) const -> bool = default;
+        };
+
+        struct Hash final {
+            auto operator()(Key const& key) const noexcept -> usize {
+                const u64 color = u64(key.color.r) | u64(key.color.g) << 8 | u64(key.color.b) << 16 | u64(key.color.a) << 24;
+                return std::hash<void const*> {}(key.font) ^ usize((u64(key.character) << 32 | color) * 0x9E3779B97F4A7C15);
+            }
+        };
+
+        /// A glyph in the atlas as a row plane, so drawing it takes the row blending path.
+        struct View final {
+            Image const* atlas;
+            Image::Region region;
+
+            auto width() const noexcept -> i32 {
+                return region.w;
+            }
+
+            auto height() const noexcept -> i32 {
+                return region.h;
+            }
+
+            auto get(i32 x, i32 y) const noexcept -> Color {
+                if (x >= 0 and x < region.w and y >= 0 and y < region.h) {
+                    return atlas->get(region.x + x, region.y + y);
+                } else {
+                    return color::CLEAR;
+                }
+            }
+
+            auto row(i32 y) const noexcept -> std::span<const Color> {
+                return atlas->row(region.y + y).subspan(region.x, region.w);
+            }
+        };
+
+        static_assert(RowPlane<View>);
+
+        static constexpr i32 ATLAS_WIDTH = 512;
+
+        std::mutex lock;
+        std::unordered_map<Key, Glyph, Hash> glyphs;
+        Image atlas { ATLAS_WIDTH, 64 };
+        /// Glyphs are packed left to right into shelves, a new shelf starts below the tallest glyph of the last.
+        i32 shelf_x { 0 }, shelf_y { 0 }, shelf_height { 0 };
+
+        /// Makes room for a glyph, doubling the height of the atlas when it's full.
+        auto allocate(i32 width, i32 height) -> Image::Region {
+            if (shelf_x + width > ATLAS_WIDTH) {
+                shelf_x = 0;
+                shelf_y += shelf_height;
+                shelf_height = 0;
+            }
+            if (shelf_y + height > atlas.height()) {
+                auto grown = Image(ATLAS_WIDTH, std::max(atlas.height() * 2, shelf_y + height));
+                grown | draw::draw(atlas, 0, 0, blend::overwrite);
+                atlas = std::move(grown);
+            }
+
+            const auto ret = Image::Region { shelf_x, shelf_y, width, height };
+            shelf_x += width;
+            shelf_height = std::max(shelf_height, height);
+            return ret;
+        }
+
+        template <Plane T, typename Chr> auto find(Font<T, Chr> const& font, Chr c, Color color) -> Glyph {
+            const auto key = Key { &font, u32(std::make_unsigned_t<Chr>(c)), color };
+            if (const auto existing = glyphs.find(key); existing != glyphs.end()) return existing->second;
+
+            using SymbolType = typename Symbol<T>::Type;
+            const auto symbol = font.symbol(c);
+
+            Glyph ret { { 0, 0, 0, 0 }, symbol.width(), symbol.type == SymbolType::Space };
+            if (not ret.space) {
+                // Glyphs wider than the atlas don't exist in any of the fonts, they'd simply be cut off.
+                ret.region = allocate(std::min(symbol.glyph.width(), ATLAS_WIDTH), symbol.glyph.height());
+                detail::draw_glyph(atlas, symbol.glyph, ret.region.x, ret.region.y, color);
+            }
+
+            glyphs.emplace(key, ret);
+            return ret;
+        }
+
+      public:
+        static auto shared() -> GlyphCache& {
+            static GlyphCache instance;
+            return instance;
+        }
+
+        /// The width of the content in the font, the same a Text of it would have.
+        template <Plane T, typename Chr> auto width(Font<T, Chr> const& font, std::type_identity_t<std::basic_string_view<Chr>> content, Color color = color::WHITE) -> i32 {
+            if (content.empty()) return 0;
+
+            std::lock_guard guard { lock };
+            i32 acc = -font.spacing;
+            for (Chr c : content) acc += find(font, c, color).width + font.spacing;
+            return acc;
+        }
+
+        /// Draws the content with its top left corner at the position, like drawing a Text of it would.
+        template <typename U, Plane T, typename Chr> void draw(
+            U& target, Font<T, Chr> const& font, std::type_identity_t<std::basic_string_view<Chr>> content, i32 x, i32 y, Color color = color::WHITE
+        ) {
+            std::lock_guard guard { lock };
+            i32 cursor = x;
+            for (Chr c : content) {
+                const auto glyph = find(font, c, color);
+                if (glyph.space) {
+                    cursor += glyph.width;
+                } else {
+                    target | draw::draw(View { &atlas, glyph.region }, cursor, y);
+                    cursor += glyph.width + font.spacing;
+                }
+            }
+        }
+
+        /// Forgets every glyph, for when fonts are unloaded.
+        void clear() {
+            std::lock_guard guard { lock };
+            glyphs.clear();
+            atlas | draw::clear();
+            shelf_x = shelf_y = shelf_height = 0;
+        }
+    };
+
+    namespace adapt {
+        template <Plane T, typename Chr> struct DrawText final {
+            std::basic_string_view<Chr> content;
+            Font<T, Chr> const& font;
+            i32 x, y;
+            Color color;
+
+            template <typename U> U& operator()(U& self) const requires SizedPlane<U> and MutablePlane<U> {
+                GlyphCache::shared().draw(self, font, content, x, y, color);
+                return self;
+            }
+        };
+    }
+
+    /// Draws text through the shared GlyphCache, which is much cheaper than drawing a new Text every frame.
+    template <Plane T, typename Chr> auto text(
+        std::type_identity_t<std::basic_string_view<Chr>> content, Font<T, Chr> const& font, i32 x, i32 y, Color color = color::WHITE
+    ) -> adapt::DrawText<T, Chr> {
+        return adapt::DrawText<T, Chr> { content, font, x, y, color };
+    }
+}
@@ -0,0 +1,175 @@
+// High dynamic range images and tone mapping them down to displayable colors.
+#pragma once
+#include <primitive>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <span>
+#include <thread>
+#include <vector>
+#include "color.hpp"
+#include "plane.hpp"
+
+namespace draw {
+    /// An image of linear floating point RGB, unbounded and without alpha, for renderers to accumulate
+    /// light in before it's tone mapped into a regular image.
+    ///
+    /// It's not a plane since its pixels aren't colors yet, a ToneMap turns it into one.
+    class HdrImage final {
+      public:
+        struct Pixel final {
+            f32 r { 0.f }, g { 0.f }, b { 0.f };
+        };
+
+      private:
+        std::vector<Pixel> data;
+        i32 w { 0 }, h { 0 };
+
+      public:
+        HdrImage() {}
+
+        HdrImage(i32 width, i32 height) : data(usize(width) * usize(height)), w(width), h(height) {}
+
+        auto width() const noexcept -> i32 {
+            return w;
+        }
+
+        auto height() const noexcept -> i32 {
+            return h;
+        }
+
+        auto get(i32 x, i32 y) const noexcept -> Pixel {
+            if (x >= 0 and x < w and y >= 0 and y < h) {
+                return data[x + y * w];
+            } else {
+                return Pixel {};
+            }
+        }
+
+        /// Distinct pixels can be set from different threads.
+        void set(i32 x, i32 y, Pixel pixel) noexcept {
+            if (x >= 0 and x < w and y >= 0 and y < h) {
+                data[x + y * w] = pixel;
+            }
+        }
+
+        auto row(i32 y) const noexcept -> std::span<const Pixel> {
+            return { data.data() + usize(y) * usize(w), usize(w) };
+        }
+
+        auto row(i32 y) noexcept -> std::span<Pixel> {
+            return { data.data() + usize(y) * usize(w), usize(w) };
+        }
+
+        /// Resizes the image, discarding its contents if the size changed.
+        void resize(i32 width, i32 height) {
+            if (width == w and height == h) return;
+            data.assign(usize(width) * usize(height), Pixel {});
+            w = width;
+            h = height;
+        }
+    };
+
+    /// Maps linear light to displayable sRGB colors: exposure, then a tone curve compressing highlights
+    /// into range, then the sRGB transfer function.
+    struct ToneMap final {
+        enum class Curve : u8 {
+            /// Clamps to one, highlights simply clip.
+            Clamp,
+            /// x / (1 + x), gentle but desaturates and never reaches white.
+            Reinhard,
+            /// The fitted ACES filmic curve by Krzysztof Narkowicz, a contrasty toe with a soft shoulder.
+            Aces,
+        };
+
+        f32 exposure { 1.f };
+        Curve curve { Curve::Aces };
+
+      private:
+        /// The encode table resolution, enough that neighbouring entries never skip an 8-bit value.
+        static constexpr usize LUT_SIZE = 4096;
+
+        /// The 8-bit sRGB encoding of evenly spaced linear values from zero to one.
+        static auto srgb_table() -> std::array<u8, LUT_SIZE> const& {
+            static const auto table = [] {
+                std::array<u8, LUT_SIZE> ret;
+                for (usize i = 0; i < LUT_SIZE; i += 1) {
+                    const f64 linear = f64(i) / f64(LUT_SIZE - 1);
+                    const f64 encoded = linear <= .0031308 ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - .055;
+                    ret[i] = u8(std::lround(std::clamp(encoded, 0.0, 1.0) * 255.0));
+                }
+                return ret;
+            }();
+            return table;
+        }
+
+        template <Curve CURVE> [[clang::always_inline]]
+        static auto apply_curve(f32 x) noexcept -> f32 {
+            if constexpr (CURVE == Curve::Clamp) {
+                return x;
+            } else if constexpr (CURVE == Curve::Reinhard) {
+                return x / (1.f + x);
+            } else {
+                return (x * (2.51f * x + .03f)) / (x * (2.43f * x + .59f) + .14f);
+            }
+        }
+
+        /// Maps one row, the curve is picked per row so the loop is branchless float arithmetic and a
+        /// table load per channel, which the compiler vectorizes for whatever the target offers.
+        /// NaNs end up black.
+        template <Curve CURVE> static void map_row(
+            std::span<const HdrImage::Pixel> source, std::span<Color> target, f32 exposure, u8 const* table
+        ) noexcept {
+            constexpr f32 SCALE = f32(LUT_SIZE - 1);
+            // Keeps infinities from turning into NaNs in the curves.
+            constexpr f32 LARGEST_INPUT = 65504.f;
+            const usize count = std::min(source.size(), target.size());
+
+            // The argument order of min and max matters, it's what sends NaNs to zero.
+            const auto encode = [&] (f32 value) -> u8 {
+                const f32 exposed = std::min(std::max(0.f, value * exposure), LARGEST_INPUT);
+                const f32 mapped = std::min(std::max(0.f, apply_curve<CURVE>(exposed)), 1.f);
+                return table[usize(mapped * SCALE + .5f)];
+            };
+
+            for (usize i = 0; i < count; i += 1) {
+                target[i] = Color::rgba(encode(source[i].r), encode(source[i].g), encode(source[i].b));
+            }
+        }
+
+      public:
+        /// Tone maps the rows `[y0, y1)` into the target, for renderers to map each batch of rows as soon
+        /// as it's done. Distinct rows can be mapped from different threads, damage is left to the caller.
+        template <MutableRowPlane T> void apply_rows(HdrImage const& source, T& target, i32 y0, i32 y1) const {
+            const i32 width = std::min(source.width(), target.width());
+            y1 = std::min({ y1, source.height(), target.height() });
+            if (width <= 0) return;
+
+            u8 const* table = srgb_table().data();
+            for (i32 y = std::max(y0, 0); y < y1; y += 1) {
+                const auto from = source.row(y).first(width);
+                const auto to = std::span<Color>(target.row(y)).first(width);
+                switch (curve) {
+                    case Curve::Clamp:    map_row<Curve::Clamp>(from, to, exposure, table);    break;
+                    case Curve::Reinhard: map_row<Curve::Reinhard>(from, to, exposure, table); break;
+                    case Curve::Aces:     map_row<Curve::Aces>(from, to, exposure, table);     break;
+                }
+            }
+        }
+
+        /// Tone maps the whole image into the target in one sweep, with bands of rows spread across
+        /// threads. The images are expected to be the same size, any excess is left alone.
+        template <MutableRowPlane T> void apply(
+            HdrImage const& source, T& target, u32 threads = std::thread::hardware_concurrency()
+        ) const {
+            const i32 width = std::min(source.width(), target.width());
+            const i32 height = std::min(source.height(), target.height());
+            if (width <= 0 or height <= 0) return;
+
+            detail::parallel_rows(0, height, threads, [&] (i32 start, i32 end) {
+                apply_rows(source, target, start, end);
+            });
+            detail::damage_region(target, 0, 0, width, height);
+        }
+    };
+}
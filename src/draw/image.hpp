@@ -5,6 +5,18 @@
 // It's not the most primitive however, that title belongs to the InfiniteImage.
 #pragma once
 #include <primitive>
+#include <io>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <stdexcept>
+#include <thread>
 #include <vector>
 #include "plane.hpp"
 
@@ -15,42 +27,138 @@ namespace draw {
     ///
     /// TODO: Replace std::vector with something sane, 24 bytes is a joke.
     class Image final {
+      public:
+        /// A rectangle of pixels within the image.
+        struct Region final {
+            i32 x, y, w, h;
+        };
+
+      private:
+        /// Which tiles of the image were written to, one bit per tile.
+        ///
+        /// Bits are set with relaxed atomics, checking first so tiles already marked cost only a load,
+        /// which keeps tracking cheap and safe while several threads draw into disjoint rows.
+        struct Damage final {
+            static constexpr i32 TILE = 32;
+
+            i32 columns, rows;
+            std::unique_ptr<std::atomic<u64>[]> words;
+
+            Damage(i32 width, i32 height)
+                : columns((width + TILE - 1) / TILE), rows((height + TILE - 1) / TILE),
+                  words(std::make_unique<std::atomic<u64>[]>((usize(columns) * usize(rows) + 63) / 64)) {}
+
+            auto word_count() const noexcept -> usize {
+                return (usize(columns) * usize(rows) + 63) / 64;
+            }
+
+            void mark_tile(usize tile) noexcept {
+                auto& word = words[tile / 64];
+                const u64 bit = u64(1) << (tile % 64);
+                if (not (word.load(std::memory_order_relaxed) & bit)) word.fetch_or(bit, std::memory_order_relaxed);
+            }
+
+            auto marked(i32 column, i32 row) const noexcept -> bool {
+                const usize tile = usize(row) * usize(columns) + usize(column);
+                return words[tile / 64].load(std::memory_order_relaxed) & (u64(1) << (tile % 64));
+            }
+
+            void mark(i32 x, i32 y) noexcept {
+                mark_tile(usize(y / TILE) * usize(columns) + usize(x / TILE));
+            }
+
+            void mark_all() noexcept {
+                for (usize i = 0; i < word_count(); i += 1) words[i].store(~u64(0), std::memory_order_relaxed);
+            }
+
+            void reset() noexcept {
+                for (usize i = 0; i < word_count(); i += 1) words[i].store(0, std::memory_order_relaxed);
+            }
+        };
+
         std::vector<Color> data;
+        /// The first pixel, which is in `data` unless the image borrows its memory.
+        Color* base { nullptr };
         i32 w, h;
+        /// The distance between the starts of consecutive rows, in pixels.
+        i32 row_stride;
+        /// Only present while damage is tracked, most images never need it.
+        std::unique_ptr<Damage> damage;
+
+        /// Points the image at its own storage, once it holds `w * h` pixels.
+        void adopt() noexcept {
+            base = data.data();
+            row_stride = w;
+        }
 
       public:
         /// The default, empty image of nil proportions.
-        Image() : w(0), h(0) {}
+        Image() : w(0), h(0), row_stride(0) {}
 
         Image(Image const&) = delete;
         auto operator=(Image const&) -> Image& = delete;
-        Image(Image&&) = default;
-        auto operator=(Image&&) -> Image& = default;
+
+        Image(Image&& other) noexcept
+            : data(std::move(other.data)), base(other.base), w(other.w), h(other.h), row_stride(other.row_stride),
+              damage(std::move(other.damage))
+        {
+            other.base = nullptr;
+            other.w = other.h = other.row_stride = 0;
+        }
+
+        auto operator=(Image&& other) noexcept -> Image& {
+            if (this != &other) {
+                data = std::move(other.data);
+                base = other.base;
+                w = other.w;
+                h = other.h;
+                row_stride = other.row_stride;
+                damage = std::move(other.damage);
+                other.base = nullptr;
+                other.w = other.h = other.row_stride = 0;
+            }
+            return *this;
+        }
 
         /// Initializes the image with the provided function of signature:
         /// (x: i32, y: i32) -> Color
         template <typename F> Image(i32 width, i32 height, F init) : w(width), h(height) {
             data.reserve(width * height);
             data.resize(width * height);
-            for (i32 x = 0; x < width; x += 1) {
-                for (i32 y = 0; y < height; y += 1) {
-                    data.at(x + y * width) = init(x, y);
+            for (i32 y = 0; y < height; y += 1) {
+                for (i32 x = 0; x < width; x += 1) {
+                    data[x + y * width] = init(x, y);
                 }
             }
+            adopt();
         }
 
-        Image(i32 width, i32 height) : Image(width, height, [] (i32 x, i32 y) { return color::CLEAR; }) {}
+        Image(i32 width, i32 height) : data(usize(width) * usize(height), color::CLEAR), w(width), h(height) {
+            adopt();
+        }
+
+        /// Creates an image drawing into memory owned by someone else, such as a locked texture, with
+        /// rows `stride` pixels apart. The memory must outlive the image and is not initialized.
+        static auto borrow(Color* pixels, i32 width, i32 height, i32 stride) noexcept -> Image {
+            Image ret;
+            ret.base = pixels;
+            ret.w = width;
+            ret.h = height;
+            ret.row_stride = stride;
+            return ret;
+        }
 
         auto clone() const -> Image {
-            return Image(w, h, [this] (i32 x, i32 y) -> Color {
-                return this->get(x, y);
-            });
+            return flatten(*this);
         }
 
+        /// Damage tracking carries over, with the whole resized image damaged.
         void resize(i32 width, i32 height) {
+            const bool tracked = damage != nullptr;
             *this = Image(width, height, [this] (i32 x, i32 y) -> Color {
                 return this->get(x, y);
             });
+            if (tracked) track_damage(true);
         }
 
         auto width() const noexcept -> i32 {
@@ -61,9 +169,19 @@ namespace draw {
             return h;
         }
 
+        /// The distance between the starts of consecutive rows in pixels, the width unless borrowed.
+        auto stride() const noexcept -> i32 {
+            return row_stride;
+        }
+
+        /// Whether the rows follow each other without padding.
+        auto contiguous() const noexcept -> bool {
+            return row_stride == w;
+        }
+
         auto get(i32 x, i32 y) const noexcept -> Color {
             if (x >= 0 and x < w and y >= 0 and y < h) {
-                return data[x + y * w];
+                return base[x + y * row_stride];
             } else {
                 return color::CLEAR;
             }
@@ -71,59 +189,453 @@ namespace draw {
 
         void set(i32 x, i32 y, Color color) noexcept {
             if (x >= 0 and x < w and y >= 0 and y < h) {
-                data[x + y * w] = color;
+                base[x + y * row_stride] = color;
+                if (damage) damage->mark(x, y);
+            }
+        }
+
+        /// Starts or stops recording which parts of the image are written to, starting with all of it.
+        ///
+        /// Every write goes through `set`, so this covers pixels, `draw::draw` and `draw::clear` alike.
+        /// Writes made through `raw` or `row` are not seen and should be reported with `damage_region`.
+        void track_damage(bool enabled) {
+            if (enabled) {
+                damage = std::make_unique<Damage>(w, h);
+                damage->mark_all();
+            } else {
+                damage.reset();
             }
         }
 
+        auto tracks_damage() const noexcept -> bool {
+            return damage != nullptr;
+        }
+
+        /// Marks a region as damaged, clipped to the image.
+        void damage_region(i32 x, i32 y, i32 width, i32 height) noexcept {
+            if (not damage) return;
+            const i32 x0 = std::max(x, 0), y0 = std::max(y, 0);
+            const i32 x1 = std::min(x + width, w), y1 = std::min(y + height, h);
+            if (x0 >= x1 or y0 >= y1) return;
+            for (i32 row = y0 / Damage::TILE; row <= (y1 - 1) / Damage::TILE; row += 1) {
+                for (i32 column = x0 / Damage::TILE; column <= (x1 - 1) / Damage::TILE; column += 1) {
+                    damage->mark_tile(usize(row) * usize(damage->columns) + usize(column));
+                }
+            }
+        }
+
+        /// Replaces the contents of `regions` with the damage since the previous call and resets it.
+        ///
+        /// Damaged tiles are merged into runs along each row of tiles, and runs spanning the same
+        /// columns in consecutive rows into one rectangle, clipped to the image. An image which doesn't
+        /// track damage is damaged entirely.
+        void take_damage(std::vector<Region>& regions) {
+            regions.clear();
+            if (not damage) {
+                if (w > 0 and h > 0) regions.push_back(Region { 0, 0, w, h });
+                return;
+            }
+
+            constexpr i32 TILE = Damage::TILE;
+            // Regions from `open` onwards end at the previous row of tiles and may still grow downwards.
+            usize open = 0;
+            for (i32 row = 0; row < damage->rows; row += 1) {
+                const usize row_start = regions.size();
+                usize candidate = open;
+
+                for (i32 column = 0; column < damage->columns;) {
+                    if (not damage->marked(column, row)) {
+                        column += 1;
+                        continue;
+                    }
+                    const i32 first = column;
+                    while (column < damage->columns and damage->marked(column, row)) column += 1;
+
+                    const i32 x = first * TILE;
+                    const i32 width = std::min(column * TILE, w) - x;
+                    const i32 y = row * TILE;
+                    const i32 height = std::min(y + TILE, h) - y;
+
+                    // Both lists are ordered by x, so the matching run above is found by walking forward.
+                    while (candidate < row_start and regions[candidate].x < x) candidate += 1;
+                    if (candidate < row_start and regions[candidate].x == x and regions[candidate].w == width) {
+                        regions[candidate].h += height;
+                        // Keep the extended region open for the next row by moving it after this row's runs.
+                        regions.push_back(regions[candidate]);
+                        regions[candidate].w = 0;
+                        candidate += 1;
+                    } else {
+                        regions.push_back(Region { x, y, width, height });
+                    }
+                }
+                open = row_start;
+            }
+
+            std::erase_if(regions, [] (Region const& region) { return region.w == 0; });
+            damage->reset();
+        }
+
         auto raw() const noexcept -> Color const* {
-            return data.data();
+            return base;
         }
 
         auto raw() -> Color* {
-            return data.data();
+            return base;
+        }
+
+        /// The pixels of a row.
+        auto row(i32 y) const noexcept -> std::span<const Color> {
+            return { base + usize(y) * usize(row_stride), usize(w) };
+        }
+
+        auto row(i32 y) noexcept -> std::span<Color> {
+            return { base + usize(y) * usize(row_stride), usize(w) };
+        }
+
+        /// Initializes the image with a copy of pixels already laid out in row-major order.
+        static auto from_pixels(i32 width, i32 height, std::span<const Color> pixels) -> Image {
+            Image ret;
+            ret.data.assign(pixels.begin(), pixels.begin() + usize(width) * usize(height));
+            ret.w = width;
+            ret.h = height;
+            ret.adopt();
+            return ret;
         }
 
+        /// Planes which store their pixels contiguously in row-major order are copied in bulk,
+        /// planes which expose rows a row at a time.
         template <SizedPlane U> static auto flatten(U const& other) -> Image {
-            return Image(other.width(), other.height(), [&] (i32 x, i32 y) -> Color {
-                return other.get(x, y);
-            });
+            if constexpr (requires { { other.pixels() } -> std::convertible_to<std::span<const Color>>; }) {
+                const std::span<const Color> pixels = other.pixels();
+                if (pixels.size() == usize(other.width()) * usize(other.height())) {
+                    return from_pixels(other.width(), other.height(), pixels);
+                }
+            }
+            if constexpr (requires { { other.row(0) } -> std::convertible_to<std::span<const Color>>; }) {
+                Image ret(other.width(), other.height());
+                for (i32 y = 0; y < other.height(); y += 1) {
+                    const std::span<const Color> row = other.row(y);
+                    std::copy(row.begin(), row.end(), ret.row(y).begin());
+                }
+                return ret;
+            } else {
+                return Image(other.width(), other.height(), [&] (i32 x, i32 y) -> Color {
+                    return other.get(x, y);
+                });
+            }
+        }
+
+        /// Flattens with bands of rows evaluated on separate threads, as many as there are cores unless
+        /// told otherwise. Planes which are already stored as pixels or rows are copied like `flatten` does.
+        ///
+        /// Only worth it for planes expensive to evaluate, like long chains of adapters and mappings.
+        template <ConcurrentPlane U> static auto flatten_parallel(U const& other, u32 threads = std::thread::hardware_concurrency()) -> Image {
+            if constexpr (RowPlane<U>) {
+                return flatten(other);
+            } else {
+                Image ret(other.width(), other.height());
+                detail::parallel_rows(0, other.height(), threads, [&] (i32 start, i32 end) {
+                    for (i32 y = start; y < end; y += 1) {
+                        const std::span<Color> row = ret.row(y);
+                        for (i32 x = 0; x < other.width(); x += 1) row[x] = other.get(x, y);
+                    }
+                });
+                return ret;
+            }
+        }
+
+        /// All pixels in row-major order, empty if the rows are padded.
+        auto pixels() const noexcept -> std::span<const Color> {
+            if (not contiguous()) return {};
+            return { base, usize(w) * usize(h) };
+        }
+
+        void serialize(io::BinaryWriter& out) const {
+            static_assert(std::is_trivially_copyable_v<Color> and sizeof(Color) == 4);
+            out.reserve(8 + usize(w) * usize(h) * sizeof(Color));
+            out.i32(w);
+            out.i32(h);
+            for (i32 y = 0; y < h; y += 1) {
+                const auto pixels = row(y);
+                out.bytes(std::span((u8 const*) pixels.data(), pixels.size() * sizeof(Color)));
+            }
+        }
+
+        /// Throws `std::out_of_range` if the data is truncated.
+        static auto deserialize(io::BinaryReader& in) -> Image {
+            const i32 width = in.i32();
+            const i32 height = in.i32();
+            if (width < 0 or height < 0) throw std::out_of_range("Image");
+
+            Image ret;
+            const auto pixels = in.bytes(usize(width) * usize(height) * sizeof(Color));
+            ret.data.resize(usize(width) * usize(height));
+            std::memcpy(ret.data.data(), pixels.data(), pixels.size());
+            ret.w = width;
+            ret.h = height;
+            ret.adopt();
+            return ret;
         }
     };
 
     // Assert that our type properly satisfies the desired interface.
-    static_assert(SizedPlane<Image> and MutablePlane<Image>);
+    static_assert(SizedPlane<Image> and MutablePlane<Image> and MutableRowPlane<Image>);
 
+    /// A TGA image decoded into memory.
+    ///
+    /// Supports uncompressed and run-length encoded true color images of 24 or 32 bits per pixel in
+    /// any origin. Pixels are converted a whole row at a time with loops simple enough for the compiler
+    /// to vectorize, so decoding large images is bound by memory bandwidth rather than per pixel work.
     class TgaImage final {
-        std::vector<u8> data;
+        Image image;
+
+        TgaImage(Image image) : image(std::move(image)) {}
+
+      public:
+        /// An error raised while decoding a malformed or unsupported image.
+        struct Error final {
+            enum class Reason {
+                Truncated,
+                UnsupportedType,
+                UnsupportedDepth,
+            } reason;
+            std::optional<std::string> description { std::nullopt };
+        };
+
+        struct Header final {
+            u8 id_length;
+            u8 color_map_type;
+            u8 image_type;
+            u16 color_map_length;
+            u8 color_map_depth;
+            u16 width;
+            u16 height;
+            u8 depth;
+            u8 descriptor;
+
+            static auto read(std::span<const u8> data) -> Header {
+                if (data.size() < 18) throw Error { Error::Reason::Truncated, "header" };
+                return Header {
+                    .id_length = data[0],
+                    .color_map_type = data[1],
+                    .image_type = data[2],
+                    .color_map_length = u16(data[5] | data[6] << 8),
+                    .color_map_depth = data[7],
+                    .width = u16(data[12] | data[13] << 8),
+                    .height = u16(data[14] | data[15] << 8),
+                    .depth = data[16],
+                    .descriptor = data[17],
+                };
+            }
 
-        struct BGRA final {
-            u8 b, g, r, a;
+            /// Where the pixel data begins, past the image id and any unused color map.
+            auto pixel_offset() const -> usize {
+                return 18 + usize(id_length) + usize(color_map_type ? color_map_length : 0) * ((color_map_depth + 7) / 8);
+            }
+
+            auto run_length_encoded() const -> bool {
+                return image_type == 10;
+            }
+
+            auto right_to_left() const -> bool {
+                return descriptor & 0x10;
+            }
 
-            constexpr operator Color() const noexcept {
-                return Color::rgba(r, g, b, a);
+            auto top_to_bottom() const -> bool {
+                return descriptor & 0x20;
             }
         };
 
-        TgaImage(std::vector<u8> data) : data(std::move(data)) {}
+      private:
+        /// Converts a row of BGRA pixels, swapping the red and blue byte of every pixel as a whole word.
+        static void convert_bgra(u8 const* __restrict in, Color* __restrict out, usize count) noexcept {
+            for (usize i = 0; i < count; i += 1) {
+                u32 p;
+                std::memcpy(&p, in + i * 4, 4);
+                p = (p & 0xFF00FF00) | (p >> 16 & 0xFF) | (p & 0xFF) << 16;
+                std::memcpy(out + i, &p, 4);
+            }
+        }
+
+        /// Converts a row of BGR pixels into opaque colors.
+        static void convert_bgr(u8 const* __restrict in, Color* __restrict out, usize count) noexcept {
+            for (usize i = 0; i < count; i += 1) {
+                out[i] = Color::rgba(in[i * 3 + 2], in[i * 3 + 1], in[i * 3], 255);
+            }
+        }
+
+        /// Expands run-length encoded pixel data into the raw layout of an uncompressed image.
+        /// Packets are allowed to cross rows, as older encoders produce them.
+        static auto expand(std::span<const u8> in, usize pixel_size, usize pixel_count) -> std::vector<u8> {
+            std::vector<u8> out(pixel_count * pixel_size);
+            usize cursor = 0;
+            usize written = 0;
+
+            while (written < pixel_count) {
+                if (cursor >= in.size()) throw Error { Error::Reason::Truncated, "run-length packet" };
+                const u8 packet = in[cursor++];
+                const usize count = std::min(usize(packet & 0x7F) + 1, pixel_count - written);
+                u8* dst = out.data() + written * pixel_size;
+
+                if (packet & 0x80) {
+                    if (cursor + pixel_size > in.size()) throw Error { Error::Reason::Truncated, "run-length packet" };
+                    for (usize i = 0; i < count; i += 1) std::memcpy(dst + i * pixel_size, in.data() + cursor, pixel_size);
+                    cursor += pixel_size;
+                } else {
+                    if (cursor + count * pixel_size > in.size()) throw Error { Error::Reason::Truncated, "raw packet" };
+                    std::memcpy(dst, in.data() + cursor, count * pixel_size);
+                    cursor += count * pixel_size;
+                }
+
+                written += count;
+            }
+
+            return out;
+        }
 
       public:
-        auto width() const -> i32 {
-            return *reinterpret_cast<u16 const*>(data.data() + 12);
+        /// Decodes the image straight into an Image, throwing `TgaImage::Error` if it can't.
+        static auto decode(std::span<const u8> data) -> Image {
+            const auto header = Header::read(data);
+            if (header.image_type != 2 and header.image_type != 10)
+                throw Error { Error::Reason::UnsupportedType, "image type " + std::to_string(header.image_type) };
+            if (header.depth != 24 and header.depth != 32)
+                throw Error { Error::Reason::UnsupportedDepth, std::to_string(header.depth) + " bits per pixel" };
+
+            const usize w = header.width;
+            const usize h = header.height;
+            const usize pixel_size = header.depth / 8;
+            const usize offset = header.pixel_offset();
+            if (offset > data.size()) throw Error { Error::Reason::Truncated, "pixel data" };
+
+            std::vector<u8> expanded;
+            auto pixels = data.subspan(offset);
+            if (header.run_length_encoded()) {
+                expanded = expand(pixels, pixel_size, w * h);
+                pixels = expanded;
+            } else if (pixels.size() < w * h * pixel_size) {
+                throw Error { Error::Reason::Truncated, "pixel data" };
+            }
+
+            Image ret = Image(i32(w), i32(h));
+            Color* out = ret.raw();
+
+            for (usize row = 0; row < h; row += 1) {
+                // Rows are stored bottom up unless the descriptor says otherwise.
+                const usize y = header.top_to_bottom() ? row : h - 1 - row;
+                u8 const* src = pixels.data() + row * w * pixel_size;
+                Color* dst = out + y * w;
+
+                if (pixel_size == 4) convert_bgra(src, dst, w);
+                else                 convert_bgr(src, dst, w);
+
+                if (header.right_to_left()) std::reverse(dst, dst + w);
+            }
+
+            return ret;
         }
 
-        auto height() const -> i32 {
-            return *reinterpret_cast<u16 const*>(data.data() + 14);
+        static auto from(std::span<const u8> data) -> TgaImage {
+            return TgaImage(decode(data));
         }
 
-        auto get(i32 x, i32 y) const -> Color {
-            return *reinterpret_cast<BGRA const*>(data.data() + 18 + (x + y * width()) * sizeof(BGRA));
+        auto width() const noexcept -> i32 {
+            return image.width();
         }
 
-        static auto from(std::vector<u8> data) -> TgaImage {
-            return TgaImage(std::move(data));
+        auto height() const noexcept -> i32 {
+            return image.height();
+        }
+
+        auto get(i32 x, i32 y) const noexcept -> Color {
+            return image.get(x, y);
+        }
+
+        auto pixels() const noexcept -> std::span<const Color> {
+            return image.pixels();
+        }
+
+        auto row(i32 y) const noexcept -> std::span<const Color> {
+            return image.row(y);
+        }
+
+        /// Takes the decoded image without copying it.
+        auto into_image() && -> Image {
+            return std::move(image);
+        }
+    };
+
+    // Assert that our type properly satisfies the desired interface.
+    static_assert(SizedPlane<TgaImage> and RowPlane<TgaImage>);
+
+    /// Reads the width of a TGA image in a constant expression.
+    constexpr auto tga_width(std::span<const u8> tga) -> i32 {
+        return tga[12] | tga[13] << 8;
+    }
+
+    /// Reads the height of a TGA image in a constant expression.
+    constexpr auto tga_height(std::span<const u8> tga) -> i32 {
+        return tga[14] | tga[15] << 8;
+    }
+
+    /// An image with dimensions known at compile time which can be created in constant expressions.
+    ///
+    /// It exists for resources embedded into the binary, decoding them while compiling places the
+    /// pixels directly in the binary and nothing is left to do at runtime but copy them out.
+    template <i32 W, i32 H> class FixedImage final {
+        std::array<Color, usize(W) * usize(H)> data {};
+
+      public:
+        constexpr FixedImage() {}
+
+        constexpr auto width() const noexcept -> i32 {
+            return W;
+        }
+
+        constexpr auto height() const noexcept -> i32 {
+            return H;
+        }
+
+        constexpr auto get(i32 x, i32 y) const noexcept -> Color {
+            if (x >= 0 and x < W and y >= 0 and y < H) {
+                return data[x + y * W];
+            } else {
+                return color::CLEAR;
+            }
+        }
+
+        constexpr auto pixels() const noexcept -> std::span<const Color> {
+            return data;
+        }
+
+        constexpr auto row(i32 y) const noexcept -> std::span<const Color> {
+            return std::span<const Color>(data).subspan(usize(y) * W, W);
+        }
+
+        /// Decodes an uncompressed 32-bit TGA, the dimensions must be the ones stored in it.
+        /// Anything else fails to compile when evaluated at compile time.
+        static consteval auto from_tga(std::span<const u8> tga) -> FixedImage {
+            if (tga.size() < 18 or tga[2] != 2 or tga[16] != 32) throw "FixedImage: unsupported TGA";
+            if (tga_width(tga) != W or tga_height(tga) != H) throw "FixedImage: dimension mismatch";
+
+            const usize offset = 18 + tga[0];
+            if (tga.size() < offset + usize(W) * usize(H) * 4) throw "FixedImage: truncated TGA";
+
+            // Bit 5 of the descriptor is set for images stored top to bottom.
+            const bool top_down = tga[17] & 0x20;
+
+            FixedImage ret;
+            for (i32 y = 0; y < H; y += 1) {
+                const i32 row = top_down ? y : H - 1 - y;
+                for (i32 x = 0; x < W; x += 1) {
+                    const usize i = offset + (usize(x) + usize(row) * W) * 4;
+                    ret.data[x + y * W] = Color::rgba(tga[i + 2], tga[i + 1], tga[i], tga[i + 3]);
+                }
+            }
+            return ret;
         }
     };
 
     // Assert that our type properly satisfies the desired interface.
-    static_assert(SizedPlane<TgaImage>);
+    static_assert(SizedPlane<FixedImage<1, 1>> and RowPlane<FixedImage<1, 1>>);
 }
@@ -0,0 +1,323 @@
+// Compact images of few colors, storing a palette index per pixel instead of the color itself.
+//
+// Font sheets and most sprites use a handful of colors, often just clear and white, which a full
+// Image stores at four bytes a pixel. An IndexedImage takes one byte and a BitImage one bit, and
+// recoloring either of them is a matter of swapping palette entries rather than mapping every pixel.
+#pragma once
+#include <primitive>
+#include <io>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <vector>
+#include "color.hpp"
+#include "plane.hpp"
+
+namespace draw {
+    namespace detail {
+        /// Writes clear to the part of a run `[x, x + out.size())` outside `[0, width)` and returns the
+        /// part inside it, as `{ first, count }` offsets into the run.
+        constexpr auto clip_run(i32 x, i32 width, std::span<Color> out) noexcept -> std::pair<i32, i32> {
+            const i32 length = i32(out.size());
+            const i32 first = std::clamp(-x, 0, length);
+            const i32 last = std::clamp(width - x, first, length);
+            std::fill(out.begin(), out.begin() + first, color::CLEAR);
+            std::fill(out.begin() + last, out.end(), color::CLEAR);
+            return { first, last - first };
+        }
+    }
+
+    /// An image of up to 256 colors with one byte per pixel.
+    ///
+    /// Pixels are indices into the palette, which can be edited in place to recolor the whole image.
+    class IndexedImage final {
+        std::vector<u8> indices;
+        std::vector<Color> colors;
+        i32 w { 0 }, h { 0 };
+
+      public:
+        IndexedImage() {}
+
+        /// An image of the first palette entry, the palette must not be empty.
+        IndexedImage(i32 width, i32 height, std::vector<Color> palette)
+            : indices(usize(width) * usize(height), 0), colors(std::move(palette)), w(width), h(height)
+        {
+            if (colors.empty() or colors.size() > 256) throw std::length_error("IndexedImage palette");
+        }
+
+        /// Flattens a plane into an image, with palette entries in the order colors first appear.
+        /// Throws `std::length_error` if it has more than 256 colors.
+        template <SizedPlane U> static auto from(U const& other) -> IndexedImage {
+            IndexedImage ret;
+            ret.w = other.width();
+            ret.h = other.height();
+            ret.indices.resize(usize(ret.w) * usize(ret.h));
+
+            for (i32 y = 0; y < ret.h; y += 1) {
+                for (i32 x = 0; x < ret.w; x += 1) {
+                    const Color color = other.get(x, y);
+                    auto found = std::find(ret.colors.begin(), ret.colors.end(), color);
+                    if (found == ret.colors.end()) {
+                        if (ret.colors.size() == 256) throw std::length_error("IndexedImage palette");
+                        found = ret.colors.insert(ret.colors.end(), color);
+                    }
+                    ret.indices[usize(x) + usize(y) * usize(ret.w)] = u8(found - ret.colors.begin());
+                }
+            }
+            if (ret.colors.empty()) ret.colors.push_back(color::CLEAR);
+            return ret;
+        }
+
+        auto width() const noexcept -> i32 {
+            return w;
+        }
+
+        auto height() const noexcept -> i32 {
+            return h;
+        }
+
+        auto get(i32 x, i32 y) const noexcept -> Color {
+            if (x >= 0 and x < w and y >= 0 and y < h) {
+                return colors[indices[x + y * w]];
+            } else {
+                return color::CLEAR;
+            }
+        }
+
+        auto index(i32 x, i32 y) const noexcept -> u8 {
+            if (x >= 0 and x < w and y >= 0 and y < h) {
+                return indices[x + y * w];
+            } else {
+                return 0;
+            }
+        }
+
+        /// The index must be within the palette.
+        void set_index(i32 x, i32 y, u8 index) noexcept {
+            if (x >= 0 and x < w and y >= 0 and y < h) {
+                indices[x + y * w] = index;
+            }
+        }
+
+        auto palette() const noexcept -> std::span<const Color> {
+            return colors;
+        }
+
+        auto palette() noexcept -> std::span<Color> {
+            return colors;
+        }
+
+        void decode(i32 x, i32 y, std::span<Color> out, std::span<const Color> palette) const noexcept {
+            if (y < 0 or y >= h) {
+                std::fill(out.begin(), out.end(), color::CLEAR);
+                return;
+            }
+            const auto [first, count] = detail::clip_run(x, w, out);
+            u8 const* source = indices.data() + usize(y) * usize(w) + usize(x + first);
+            for (i32 i = 0; i < count; i += 1) out[first + i] = palette[source[i]];
+        }
+
+        void serialize(io::BinaryWriter& out) const {
+            static_assert(std::is_trivially_copyable_v<Color> and sizeof(Color) == 4);
+            out.reserve(12 + colors.size() * sizeof(Color) + indices.size());
+            out.i32(w);
+            out.i32(h);
+            out.u32(u32(colors.size()));
+            out.bytes(std::span((u8 const*) colors.data(), colors.size() * sizeof(Color)));
+            out.bytes(indices);
+        }
+
+        /// Throws `std::out_of_range` if the data is truncated or malformed.
+        static auto deserialize(io::BinaryReader& in) -> IndexedImage {
+            IndexedImage ret;
+            ret.w = in.i32();
+            ret.h = in.i32();
+            const u32 count = in.u32();
+            if (ret.w < 0 or ret.h < 0 or count == 0 or count > 256) throw std::out_of_range("IndexedImage");
+            // Checked up front so corrupt sizes can't ask for a huge allocation.
+            if (count * sizeof(Color) + usize(ret.w) * usize(ret.h) > in.remaining()) throw std::out_of_range("IndexedImage");
+
+            const auto palette = in.bytes(count * sizeof(Color));
+            ret.colors.resize(count);
+            std::memcpy(ret.colors.data(), palette.data(), palette.size());
+
+            const auto indices = in.bytes(usize(ret.w) * usize(ret.h));
+            ret.indices.assign(indices.begin(), indices.end());
+            if (std::any_of(ret.indices.begin(), ret.indices.end(), [count] (u8 index) { return index >= count; })) {
+                throw std::out_of_range("IndexedImage");
+            }
+            return ret;
+        }
+    };
+
+    /// An image of two colors with one bit per pixel, for monochrome sheets like fonts.
+    ///
+    /// Rows start on byte boundaries and pixels are stored from the least significant bit up.
+    class BitImage final {
+        std::vector<u8> bits;
+        std::array<Color, 2> colors { color::CLEAR, color::WHITE };
+        i32 w { 0 }, h { 0 };
+        /// The length of a row in bytes.
+        i32 row_bytes { 0 };
+
+        static constexpr auto row_bytes_of(i32 width) noexcept -> i32 {
+            return i32((i64(width) + 7) / 8);
+        }
+
+      public:
+        BitImage() {}
+
+        /// An image of the first color.
+        BitImage(i32 width, i32 height, std::array<Color, 2> palette = { color::CLEAR, color::WHITE })
+            : bits(usize(row_bytes_of(width)) * usize(height), 0), colors(palette), w(width), h(height), row_bytes(row_bytes_of(width)) {}
+
+        /// Flattens a plane into an image, its first color being the one in the top left corner.
+        /// Throws `std::length_error` if it has more than two colors.
+        template <SizedPlane U> static auto from(U const& other) -> BitImage {
+            const Color first = other.get(0, 0);
+            BitImage ret(other.width(), other.height(), { first, first });
+
+            bool second_seen = false;
+            for (i32 y = 0; y < ret.h; y += 1) {
+                for (i32 x = 0; x < ret.w; x += 1) {
+                    const Color color = other.get(x, y);
+                    if (color == first) continue;
+                    if (not second_seen) {
+                        ret.colors[1] = color;
+                        second_seen = true;
+                    } else if (color != ret.colors[1]) {
+                        throw std::length_error("BitImage palette");
+                    }
+                    ret.set_index(x, y, 1);
+                }
+            }
+            return ret;
+        }
+
+        auto width() const noexcept -> i32 {
+            return w;
+        }
+
+        auto height() const noexcept -> i32 {
+            return h;
+        }
+
+        auto get(i32 x, i32 y) const noexcept -> Color {
+            return colors[index(x, y)];
+        }
+
+        auto index(i32 x, i32 y) const noexcept -> u8 {
+            if (x >= 0 and x < w and y >= 0 and y < h) {
+                return (bits[usize(y) * usize(row_bytes) + usize(x / 8)] >> (x % 8)) & 1;
+            } else {
+                return 0;
+            }
+        }
+
+        /// Sets the pixel to the first color for zero and the second for anything else.
+        void set_index(i32 x, i32 y, u8 index) noexcept {
+            if (x >= 0 and x < w and y >= 0 and y < h) {
+                u8& byte = bits[usize(y) * usize(row_bytes) + usize(x / 8)];
+                const u8 mask = u8(1 << (x % 8));
+                byte = index ? byte | mask : byte & ~mask;
+            }
+        }
+
+        auto palette() const noexcept -> std::span<const Color> {
+            return colors;
+        }
+
+        auto palette() noexcept -> std::span<Color> {
+            return colors;
+        }
+
+        void decode(i32 x, i32 y, std::span<Color> out, std::span<const Color> palette) const noexcept {
+            if (y < 0 or y >= h) {
+                std::fill(out.begin(), out.end(), color::CLEAR);
+                return;
+            }
+            const auto [first, count] = detail::clip_run(x, w, out);
+            u8 const* row = bits.data() + usize(y) * usize(row_bytes);
+            const Color zero = palette[0], one = palette[1];
+            for (i32 i = 0; i < count; i += 1) {
+                const i32 px = x + first + i;
+                out[first + i] = (row[px / 8] >> (px % 8)) & 1 ? one : zero;
+            }
+        }
+
+        void serialize(io::BinaryWriter& out) const {
+            static_assert(std::is_trivially_copyable_v<Color> and sizeof(Color) == 4);
+            out.reserve(8 + sizeof(colors) + bits.size());
+            out.i32(w);
+            out.i32(h);
+            out.bytes(std::span((u8 const*) colors.data(), sizeof(colors)));
+            out.bytes(bits);
+        }
+
+        /// Throws `std::out_of_range` if the data is truncated.
+        static auto deserialize(io::BinaryReader& in) -> BitImage {
+            const i32 width = in.i32();
+            const i32 height = in.i32();
+            if (width < 0 or height < 0) throw std::out_of_range("BitImage");
+            // Checked up front so corrupt sizes can't ask for a huge allocation.
+            if (sizeof(colors) + usize(row_bytes_of(width)) * usize(height) > in.remaining()) throw std::out_of_range("BitImage");
+
+            BitImage ret(width, height);
+            const auto palette = in.bytes(sizeof(ret.colors));
+            std::memcpy(ret.colors.data(), palette.data(), palette.size());
+            const auto bits = in.bytes(ret.bits.size());
+            std::copy(bits.begin(), bits.end(), ret.bits.begin());
+            return ret;
+        }
+    };
+
+    /// An indexed plane seen through another palette, which recolors it without copying any pixels.
+    ///
+    /// The palette is borrowed and must outlive the plane.
+    template <IndexedPlane T> struct Recolored final {
+        T inner;
+        std::span<const Color> colors;
+
+        constexpr auto width() const noexcept -> i32 {
+            return inner.width();
+        }
+
+        constexpr auto height() const noexcept -> i32 {
+            return inner.height();
+        }
+
+        constexpr auto get(i32 x, i32 y) const -> Color {
+            Color ret;
+            inner.decode(x, y, std::span(&ret, 1), colors);
+            return ret;
+        }
+
+        constexpr auto palette() const noexcept -> std::span<const Color> {
+            return colors;
+        }
+
+        constexpr void decode(i32 x, i32 y, std::span<Color> out, std::span<const Color> palette) const {
+            inner.decode(x, y, out, palette);
+        }
+    };
+
+    namespace adapt {
+        struct Recolor final {
+            std::span<const Color> palette;
+
+            template <IndexedPlane T> constexpr auto operator()(T inner) const noexcept -> Recolored<T> {
+                return Recolored<T> { inner, palette };
+            }
+        };
+    }
+
+    /// Views an indexed plane through another palette, see Recolored.
+    constexpr adapt::Recolor recolor(std::span<const Color> palette [[clang::lifetimebound]]) noexcept {
+        return adapt::Recolor { palette };
+    }
+
+    static_assert(IndexedPlane<IndexedImage> and IndexedPlane<BitImage>);
+    static_assert(IndexedPlane<Slice<Ref<const BitImage>>> and IndexedPlane<Recolored<Slice<Ref<const BitImage>>>>);
+}
@@ -67,6 +67,13 @@
 #include <primitive>
 #include <utility>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
 #include "color.hpp"
 
 namespace draw {
@@ -98,6 +105,44 @@ namespace draw {
     template <typename Self, typename From> concept PrimitivePlane = SizedPlane<From> and requires(From const& other) {
         { Self::flatten(other) } -> std::same_as<Self>;
     };
+
+    /// A refinement for planes which store each row contiguously, such as images.
+    ///
+    /// `row(y)` must return exactly `width()` pixels for every `y` in `[0, height())`, and agree with `get`.
+    /// Algorithms use it to work on whole rows at once instead of bounds checking every pixel,
+    /// lazy planes simply don't implement it and take the per pixel path.
+    template <typename Self> concept RowPlane = SizedPlane<Self> and requires(Self const& self, i32 y) {
+        { self.row(y) } -> std::convertible_to<std::span<const Color>>;
+    };
+
+    /// A row plane which also hands out its rows for writing.
+    template <typename Self> concept MutableRowPlane = RowPlane<Self> and MutablePlane<Self> and requires(Self& self, i32 y) {
+        { self.row(y) } -> std::same_as<std::span<Color>>;
+    };
+
+    /// A plane storing a palette index per pixel instead of colors, which has no rows of colors to hand
+    /// out and decodes runs of a row instead.
+    ///
+    /// `decode(x, y, out, palette)` writes the `out.size()` pixels starting at `x` looked up in the palette,
+    /// clear outside the plane like `get`. Passing a palette other than its own recolors the plane without
+    /// touching its pixels, the palette must then have an entry for every index in use.
+    template <typename Self> concept IndexedPlane = SizedPlane<Self> and requires(Self const& self, i32 x, i32 y, std::span<Color> out) {
+        { self.palette() } -> std::convertible_to<std::span<const Color>>;
+        self.decode(x, y, out, self.palette());
+    };
+
+    /// Opts a plane out of concurrent reads, for planes whose `get` mutates state such as a cache.
+    ///
+    /// Adapters are templates over the planes they wrap and inherit the opt out from any of them.
+    /// Planes hidden from the type, like ones captured by a mapping function, can't be seen through.
+    template <typename T> constexpr bool disable_concurrent_get = false;
+
+    template <template <typename...> typename A, typename... Ts>
+    constexpr bool disable_concurrent_get<A<Ts...>> = (disable_concurrent_get<std::remove_cvref_t<Ts>> or ...);
+
+    /// A refinement for planes on which `get` may be called from multiple threads at once,
+    /// which is what the parallel algorithms require of their sources.
+    template <typename Self> concept ConcurrentPlane = SizedPlane<Self> and not disable_concurrent_get<std::remove_cvref_t<Self>>;
 }
 
 /// Performs forwarding adapter composition. Based on the design of std::ranges.
@@ -112,10 +157,21 @@ constexpr auto operator|(Self&& self, Adapt&& adapt) noexcept(noexcept(std::forw
 ///
 /// Comparing infinite drawables is often possible through various tricks based on the math behind
 /// its infinite size, except for some truly infinite planes like an InfiniteImage (type not implemented in the C++ version).
+///
+/// Row planes are compared a row at a time, the rest pixel by pixel in row-major order.
 template <draw::SizedPlane L, draw::SizedPlane R> constexpr auto operator==(L const& lhs, R const& rhs) -> bool {
     if (lhs.width() != rhs.width() or lhs.height() != rhs.height()) return false;
-    for (i32 x = 0; x < lhs.width(); x += 1) {
-        for (i32 y = 0; y < lhs.height(); y += 1) {
+    if constexpr (draw::RowPlane<L> and draw::RowPlane<R>) {
+        if not consteval {
+            for (i32 y = 0; y < lhs.height(); y += 1) {
+                const std::span<const draw::Color> l = lhs.row(y), r = rhs.row(y);
+                if (std::memcmp(l.data(), r.data(), l.size_bytes()) != 0) return false;
+            }
+            return true;
+        }
+    }
+    for (i32 y = 0; y < lhs.height(); y += 1) {
+        for (i32 x = 0; x < lhs.width(); x += 1) {
             if (lhs.get(x, y) != rhs.get(x, y)) return false;
         }
     }
@@ -225,14 +281,70 @@ namespace draw {
 
 // Mutation ------------------------------------------------------------------------------------------------------------
 namespace draw {
+    namespace detail {
+        /// Writing rows directly bypasses `set`, planes which track what's written to are told separately.
+        template <typename T> constexpr void damage_region(T& plane, i32 x, i32 y, i32 width, i32 height) {
+            if constexpr (requires { plane.damage_region(x, y, width, height); }) {
+                plane.damage_region(x, y, width, height);
+            }
+        }
+
+        /// Writes the color to the pixels `[x0, x1)` of a row, which must lie within the plane.
+        /// Damage is left to the caller, which usually covers a whole shape at once.
+        template <typename T> constexpr void fill_span(T& plane, i32 y, i32 x0, i32 x1, Color color) {
+            if constexpr (MutableRowPlane<T>) {
+                if not consteval {
+                    const std::span<Color> row = plane.row(y);
+                    std::fill(row.begin() + x0, row.begin() + x1, color);
+                    return;
+                }
+            }
+            for (i32 x = x0; x < x1; x += 1) plane.set(x, y, color);
+        }
+
+        /// Calls the function of signature (y_start: i32, y_end: i32) -> void on bands of the rows in
+        /// `[y0, y1)` spread across threads, which take bands from a shared counter until none are left.
+        template <typename F> void parallel_rows(i32 y0, i32 y1, u32 thread_count, F const& fn) {
+            constexpr i32 BAND_ROWS = 16;
+            const i32 band_count = y1 > y0 ? (y1 - y0 + BAND_ROWS - 1) / BAND_ROWS : 0;
+            thread_count = std::min(std::max(thread_count, 1u), u32(std::max(band_count, 1)));
+
+            if (thread_count == 1) {
+                fn(y0, y1);
+                return;
+            }
+
+            std::atomic<i32> next_band { 0 };
+            std::vector<std::jthread> threads;
+            threads.reserve(thread_count);
+
+            for (u32 t = 0; t < thread_count; t += 1) {
+                threads.emplace_back([&] {
+                    for (i32 band; (band = next_band.fetch_add(1, std::memory_order_relaxed)) < band_count;) {
+                        const i32 start = y0 + band * BAND_ROWS;
+                        fn(start, std::min(y1, start + BAND_ROWS));
+                    }
+                });
+            }
+        }
+    }
+
     namespace adapt {
         struct Clear final {
             Color color;
 
             template <typename T> constexpr T& operator()(T& self) const requires SizedPlane<T> and MutablePlane<T> {
-                for (i32 x = 0; x < self.width(); x += 1) {
+                if constexpr (MutableRowPlane<T>) {
                     for (i32 y = 0; y < self.height(); y += 1) {
-                        self.set(x, y, color);
+                        const std::span<Color> row = self.row(y);
+                        std::fill(row.begin(), row.end(), color);
+                    }
+                    detail::damage_region(self, 0, 0, self.width(), self.height());
+                } else {
+                    for (i32 y = 0; y < self.height(); y += 1) {
+                        for (i32 x = 0; x < self.width(); x += 1) {
+                            self.set(x, y, color);
+                        }
                     }
                 }
                 return self;
@@ -257,7 +369,71 @@ namespace draw {
             i32 sx, sy, dx, dy;
             Color color;
 
-            template <MutablePlane T> constexpr T& operator()(T& self) const {
+            /// Sized targets are clipped first, so only the visible part of the line is walked and at most
+            /// one step is taken per column or row of the target, whatever the length of the line.
+            /// Runs of pixels on the same row are written as spans.
+            ///
+            /// Each pixel is on the row or column closest to the ideal line, rounding halves up.
+            template <SizedPlane T> constexpr T& operator()(T& self) const requires MutablePlane<T> {
+                const i64 delta_x = std::abs(i64(dx) - sx), delta_y = std::abs(i64(dy) - sy);
+                const i32 step_x = sx < dx ? 1 : -1, step_y = sy < dy ? 1 : -1;
+                const bool x_major = delta_x >= delta_y;
+                const i64 major = x_major ? delta_x : delta_y, minor = x_major ? delta_y : delta_x;
+
+                // The range of steps along the major axis which lands inside the target.
+                const i32 start = x_major ? sx : sy, step = x_major ? step_x : step_y;
+                const i32 extent = x_major ? self.width() : self.height();
+                const i64 first = std::max<i64>(0, step > 0 ? -i64(start) : i64(start) - (extent - 1));
+                const i64 last = std::min<i64>(major, step > 0 ? i64(extent - 1) - start : i64(start));
+                if (first > last) return self;
+
+                const auto minor_at = [&] (i64 t) -> i64 {
+                    // The rounded t * minor / major, split into quotient and remainder because the
+                    // product of two spans of i32 coordinates only fits in 64 bits unsigned.
+                    const u64 product = u64(t) * u64(minor);
+                    const u64 quotient = major == 0 ? 0 : product / u64(major), remainder = major == 0 ? 0 : product % u64(major);
+                    const i64 offset = i64(quotient) + (2 * remainder >= u64(major) and major != 0 ? 1 : 0);
+                    return (x_major ? sy : sx) + (x_major ? step_y : step_x) * offset;
+                };
+
+                i32 min_x = self.width(), max_x = -1, min_y = self.height(), max_y = -1;
+                const auto emit = [&] (i32 y, i32 x0, i32 x1) {
+                    if (y < 0 or y >= self.height()) return;
+                    x0 = std::max(x0, 0);
+                    x1 = std::min(x1, self.width());
+                    if (x0 >= x1) return;
+                    detail::fill_span(self, y, x0, x1, color);
+                    min_x = std::min(min_x, x0);
+                    max_x = std::max(max_x, x1);
+                    min_y = std::min(min_y, y);
+                    max_y = std::max(max_y, y + 1);
+                };
+
+                if (x_major) {
+                    // A run continues while the row stays the same.
+                    i64 run_start = first;
+                    i64 run_y = minor_at(first);
+                    for (i64 t = first + 1; t <= last + 1; t += 1) {
+                        const i64 y = t <= last ? minor_at(t) : run_y + 1;
+                        if (y == run_y) continue;
+                        const i64 a = sx + step_x * run_start, b = sx + step_x * (t - 1);
+                        emit(i32(run_y), i32(std::min(a, b)), i32(std::max(a, b)) + 1);
+                        run_start = t;
+                        run_y = y;
+                    }
+                } else {
+                    for (i64 t = first; t <= last; t += 1) {
+                        const i64 x = minor_at(t);
+                        if (x >= 0 and x < self.width()) emit(i32(sy + step_y * t), i32(x), i32(x) + 1);
+                    }
+                }
+
+                if (min_x <= max_x) detail::damage_region(self, min_x, min_y, max_x - min_x, max_y - min_y);
+                return self;
+            }
+
+            /// Unsized targets have nothing to clip against and are walked point by point.
+            template <MutablePlane T> constexpr T& operator()(T& self) const requires (not SizedPlane<T>) {
                 i32 x0 = sx;
                 i32 y0 = sy;
                 i32 x1 = dx;
@@ -296,12 +472,86 @@ namespace draw {
             constexpr Draw(D const& drawable, i32 x, i32 y, Blend blend_mode)
                 : drawable(drawable), x(x), y(y), blend_mode(blend_mode) {}
 
+            /// The drawable area clipped to the target, in drawable coordinates as `{ x0, x1, y0, y1 }`,
+            /// empty if nothing is visible.
+            template <SizedPlane T> constexpr auto clip(T const& self) const -> std::array<i32, 4> {
+                const i32 x0 = std::max(0, -this->x), x1 = std::min(drawable.width(), self.width() - this->x);
+                const i32 y0 = std::max(0, -this->y), y1 = std::min(drawable.height(), self.height() - this->y);
+                if (x0 >= x1 or y0 >= y1) return { 0, 0, 0, 0 };
+                return { x0, x1, y0, y1 };
+            }
+
+            /// Blends the clipped rows `[y0, y1)` of the drawable into a row target, without marking damage.
+            /// Distinct rows can be drawn from different threads.
+            template <MutableRowPlane T> constexpr void draw_rows(T& self, i32 x0, i32 x1, i32 y0, i32 y1) const {
+                // The common blend modes have row kernels, custom ones go pixel by pixel.
+                if constexpr (RowPlane<D> and std::convertible_to<Blend, Color (*)(Color, Color) noexcept>) {
+                    if not consteval {
+                        if (const auto kernel = blend::rows::of(blend_mode)) {
+                            for (i32 y = y0; y < y1; y += 1) {
+                                const std::span<const Color> source = drawable.row(y);
+                                kernel(source.subspan(x0, x1 - x0), self.row(y + this->y).subspan(x0 + this->x, x1 - x0));
+                            }
+                            return;
+                        }
+                    }
+                }
+
+                // Indexed drawables are decoded a run at a time into a buffer and blended from there.
+                if constexpr (not RowPlane<D> and IndexedPlane<D>) {
+                    if not consteval {
+                        constexpr i32 RUN = 256;
+                        std::array<Color, RUN> buffer;
+                        const std::span<const Color> palette = drawable.palette();
+                        void (*kernel)(std::span<const Color>, std::span<Color>) noexcept = nullptr;
+                        if constexpr (std::convertible_to<Blend, Color (*)(Color, Color) noexcept>) kernel = blend::rows::of(blend_mode);
+
+                        for (i32 y = y0; y < y1; y += 1) {
+                            const std::span<Color> target = self.row(y + this->y);
+                            for (i32 x = x0; x < x1; x += RUN) {
+                                const i32 count = std::min(RUN, x1 - x);
+                                const std::span<Color> source = std::span(buffer).first(count);
+                                drawable.decode(x, y, source, palette);
+                                if (kernel) {
+                                    kernel(source, target.subspan(x + this->x, count));
+                                } else {
+                                    for (i32 i = 0; i < count; i += 1) {
+                                        target[x + this->x + i] = source[i].blend_over(target[x + this->x + i], blend_mode);
+                                    }
+                                }
+                            }
+                        }
+                        return;
+                    }
+                }
+
+                for (i32 y = y0; y < y1; y += 1) {
+                    Color* target = self.row(y + this->y).data() + this->x;
+                    if constexpr (RowPlane<D>) {
+                        Color const* source = std::span<const Color>(drawable.row(y)).data();
+                        for (i32 x = x0; x < x1; x += 1) target[x] = source[x].blend_over(target[x], blend_mode);
+                    } else {
+                        for (i32 x = x0; x < x1; x += 1) target[x] = drawable.get(x, y).blend_over(target[x], blend_mode);
+                    }
+                }
+            }
+
             template <typename T> constexpr T& operator()(T& self) const requires SizedPlane<T> and MutablePlane<T> {
                 const auto width = drawable.width();
                 const auto height = drawable.height();
 
-                for (i32 x = 0; x < width; x += 1) {
-                    for (i32 y = 0; y < height; y += 1) {
+                // Row targets are clipped up front and written a row at a time without any bounds checks.
+                if constexpr (MutableRowPlane<T>) {
+                    const auto [x0, x1, y0, y1] = clip(self);
+                    if (x0 >= x1) return self;
+
+                    draw_rows(self, x0, x1, y0, y1);
+                    detail::damage_region(self, x0 + this->x, y0 + this->y, x1 - x0, y1 - y0);
+                    return self;
+                }
+
+                for (i32 y = 0; y < height; y += 1) {
+                    for (i32 x = 0; x < width; x += 1) {
                         self.set(
                             x + this->x, y + this->y,
                             drawable.get(x, y).blend_over(self.get(x + this->x, y + this->y), blend_mode)
@@ -312,6 +562,30 @@ namespace draw {
                 return self;
             }
         };
+
+        /// Draws like Draw, with bands of rows spread across threads.
+        ///
+        /// Only worth it for drawables expensive to evaluate, like full screen effects built with `map`.
+        /// Targets without rows can't be written concurrently and are drawn on the calling thread.
+        template <ConcurrentPlane D, typename Blend> struct ParallelDraw final {
+            Draw<D, Blend> inner;
+            u32 thread_count;
+
+            template <typename T> T& operator()(T& self) const requires SizedPlane<T> and MutablePlane<T> {
+                if constexpr (MutableRowPlane<T>) {
+                    const auto [x0, x1, y0, y1] = inner.clip(self);
+                    if (x0 >= x1) return self;
+
+                    detail::parallel_rows(y0, y1, thread_count, [&] (i32 start, i32 end) {
+                        inner.draw_rows(self, x0, x1, start, end);
+                    });
+                    detail::damage_region(self, x0 + inner.x, y0 + inner.y, x1 - x0, y1 - y0);
+                    return self;
+                } else {
+                    return inner(self);
+                }
+            }
+        };
     }
 
     constexpr adapt::Clear clear(Color color = color::CLEAR) {
@@ -334,6 +608,17 @@ namespace draw {
         return adapt::Draw { drawable, x, y, blend::binary };
     }
 
+    /// Draws on as many threads as there are cores unless told otherwise, see adapt::ParallelDraw.
+    template <ConcurrentPlane D, typename Blend> auto draw_parallel(
+        D const& drawable, i32 x, i32 y, Blend blend_mode, u32 threads = std::thread::hardware_concurrency()
+    ) -> adapt::ParallelDraw<D, Blend> {
+        return adapt::ParallelDraw<D, Blend> { adapt::Draw { drawable, x, y, blend_mode }, threads };
+    }
+
+    template <ConcurrentPlane D> auto draw_parallel(D const& drawable, i32 x, i32 y) -> adapt::ParallelDraw<D, decltype(&blend::binary)> {
+        return draw_parallel(drawable, x, y, &blend::binary);
+    }
+
     constexpr adapt::Line line(i32 sx, i32 sy, i32 dx, i32 dy, Color color = color::WHITE) {
         return adapt::Line { sx, sy, dx, dy, color };
     }
@@ -362,6 +647,25 @@ namespace draw {
         constexpr void set(i32 x, i32 y, Color color) noexcept(noexcept(inner.set(x, y, color))) requires MutablePlane<T> {
             inner.set(x, y, color);
         }
+
+        /// Rows are writable through a reference to a mutable plane, like its pixels.
+        constexpr auto row(i32 y) const -> decltype(auto) requires RowPlane<T> {
+            return inner.row(y);
+        }
+
+        constexpr void damage_region(i32 x, i32 y, i32 width, i32 height) const
+            requires requires (T& plane) { plane.damage_region(x, y, width, height); }
+        {
+            inner.damage_region(x, y, width, height);
+        }
+
+        constexpr auto palette() const -> std::span<const Color> requires IndexedPlane<T> {
+            return inner.palette();
+        }
+
+        constexpr void decode(i32 x, i32 y, std::span<Color> out, std::span<const Color> palette) const requires IndexedPlane<T> {
+            inner.decode(x, y, out, palette);
+        }
     };
 
     template <Plane T> class Slice final {
@@ -415,6 +719,24 @@ namespace draw {
         constexpr auto shift(i32 off_x, i32 off_y) const noexcept -> Slice {
             return Slice { inner, x + off_x, y + off_y, w, h };
         }
+
+        /// The sliced plane.
+        constexpr auto source() const noexcept -> T const& {
+            return inner;
+        }
+
+        /// Where the slice starts within the sliced plane.
+        constexpr auto origin() const noexcept -> std::pair<i32, i32> {
+            return { x, y };
+        }
+
+        constexpr auto palette() const -> std::span<const Color> requires IndexedPlane<T> {
+            return inner.palette();
+        }
+
+        constexpr void decode(i32 x, i32 y, std::span<Color> out, std::span<const Color> palette) const requires IndexedPlane<T> {
+            inner.decode(this->x + x, this->y + y, out, palette);
+        }
     };
 
     template <Plane T> struct Grid final {
@@ -821,6 +1143,10 @@ namespace draw {
         }
     };
 
+    /// The axis is a value rather than a type, so the generic pass through doesn't match.
+    template <MirrorAxis AXIS, SizedPlane T>
+    constexpr bool disable_concurrent_get<MirroredPlane<AXIS, T>> = disable_concurrent_get<T>;
+
     template <SizedPlane T> struct RotatedPlane final {
         T inner;
         i32 rotation_step;
@@ -963,3 +1289,166 @@ namespace draw {
         return adapt::RotateGlobal { step };
     }
 }
+
+// Fusion --------------------------------------------------------------------------------------------------------------
+// Geometric adapters only remap coordinates, yet every layer of a chain is paid for on every pixel,
+// the rotation switches, the modulo of a repeat and the offsets alike. Fusing folds the whole chain
+// into a single integer affine map, the shape of the result is decided at compile time and the map
+// itself once when fusing, so a get costs one multiply-add per axis however deep the chain was.
+namespace draw {
+    /// An integer affine map of plane coordinates, `(xx * x + xy * y + dx, yx * x + yy * y + dy)`.
+    struct AffineMap final {
+        i32 xx { 1 }, xy { 0 }, dx { 0 };
+        i32 yx { 0 }, yy { 1 }, dy { 0 };
+
+        static constexpr auto translation(i32 x, i32 y) noexcept -> AffineMap {
+            return { 1, 0, x, 0, 1, y };
+        }
+
+        constexpr auto apply(i32 x, i32 y) const noexcept -> std::pair<i32, i32> {
+            return { xx * x + xy * y + dx, yx * x + yy * y + dy };
+        }
+
+        /// The map applying `first` and then this one.
+        constexpr auto after(AffineMap first) const noexcept -> AffineMap {
+            return {
+                xx * first.xx + xy * first.yx, xx * first.xy + xy * first.yy, xx * first.dx + xy * first.dy + dx,
+                yx * first.xx + yy * first.yx, yx * first.xy + yy * first.yy, yx * first.dx + yy * first.dy + dy,
+            };
+        }
+    };
+
+    /// A plane seen through an affine map, what chains of geometric adapters fuse into.
+    ///
+    /// A repeat can't be expressed as an affine map, so with WRAP coordinates first go through `outer`
+    /// and are wrapped into the period before going through `map`.
+    template <Plane T, const bool WRAP = false> struct AffinePlane final {
+        static constexpr bool WRAPS = WRAP;
+
+        T inner;
+        AffineMap map;
+        i32 w, h;
+        AffineMap outer {};
+        i32 period_w { 1 }, period_h { 1 };
+
+        constexpr auto width() const noexcept -> i32 {
+            return w;
+        }
+
+        constexpr auto height() const noexcept -> i32 {
+            return h;
+        }
+
+        /// The coordinates in the inner plane a pixel comes from.
+        constexpr auto source(i32 x, i32 y) const noexcept -> std::pair<i32, i32> {
+            if constexpr (WRAP) {
+                const auto [ox, oy] = outer.apply(x, y);
+                return map.apply(math::arithmetic_mod(ox, period_w), math::arithmetic_mod(oy, period_h));
+            } else {
+                return map.apply(x, y);
+            }
+        }
+
+        constexpr auto get(i32 x, i32 y) const noexcept(noexcept(inner.get(x, y))) -> Color {
+            const auto [sx, sy] = source(x, y);
+            return inner.get(sx, sy);
+        }
+
+        constexpr void set(i32 x, i32 y, Color color) noexcept(noexcept(inner.set(x, y, color))) requires MutablePlane<T> {
+            const auto [sx, sy] = source(x, y);
+            inner.set(sx, sy, color);
+        }
+
+        /// The same plane viewed through another map first, resized, which is how each layer of a chain folds in.
+        constexpr auto precompose(AffineMap first, i32 width, i32 height) const noexcept -> AffinePlane {
+            if constexpr (WRAP) {
+                return AffinePlane { inner, map, width, height, outer.after(first), period_w, period_h };
+            } else {
+                return AffinePlane { inner, map.after(first), width, height };
+            }
+        }
+    };
+
+    template <Plane T, const bool WRAP>
+    constexpr bool disable_concurrent_get<AffinePlane<T, WRAP>> = disable_concurrent_get<T>;
+
+    namespace adapt {
+        struct Fuse final {
+            /// Anything which isn't a geometric adapter is the root of the chain.
+            template <Plane T> static constexpr auto fold(T const& plane) -> AffinePlane<T> {
+                if constexpr (SizedPlane<T>) {
+                    return AffinePlane<T> { plane, AffineMap {}, plane.width(), plane.height() };
+                } else {
+                    // Only reached through a slice, which provides the size.
+                    return AffinePlane<T> { plane, AffineMap {}, 0, 0 };
+                }
+            }
+
+            template <Plane T, const bool WRAP> static constexpr auto fold(AffinePlane<T, WRAP> const& plane) -> AffinePlane<T, WRAP> {
+                return plane;
+            }
+
+            template <Plane T> static constexpr auto fold(draw::Slice<T> const& plane) {
+                const auto [x, y] = plane.origin();
+                return fold(plane.source()).precompose(AffineMap::translation(x, y), plane.width(), plane.height());
+            }
+
+            template <MirrorAxis AXIS, SizedPlane T> static constexpr auto fold(MirroredPlane<AXIS, T> const& plane) {
+                const auto inner = fold(plane.inner);
+                const i32 w = inner.width(), h = inner.height();
+                if constexpr (AXIS == MirrorAxis::X) {
+                    return inner.precompose({ -1, 0, w - 1, 0, 1, 0 }, w, h);
+                } else {
+                    return inner.precompose({ 1, 0, 0, 0, -1, h - 1 }, w, h);
+                }
+            }
+
+            template <SizedPlane T> static constexpr auto fold(RotatedPlane<T> const& plane) {
+                const auto inner = fold(plane.inner);
+                const i32 w = inner.width(), h = inner.height();
+                switch (math::arithmetic_mod(plane.rotation_step, 4)) {
+                    case 1: return inner.precompose({ 0, -1, w - 1, 1, 0, 0 }, h, w);
+                    case 2: return inner.precompose({ -1, 0, w - 1, 0, -1, h - 1 }, w, h);
+                    case 3: return inner.precompose({ 0, 1, 0, -1, 0, h - 1 }, h, w);
+                    default: return inner;
+                }
+            }
+
+            template <Plane T> static constexpr auto fold(RotatedGlobalPlane<T> const& plane) {
+                const auto inner = fold(plane.inner);
+                const i32 w = inner.width(), h = inner.height();
+                switch (math::arithmetic_mod(plane.rotation_step, 4)) {
+                    case 1: return inner.precompose({ 0, 1, 0, -1, 0, 0 }, w, h);
+                    case 2: return inner.precompose({ -1, 0, 0, 0, -1, 0 }, w, h);
+                    case 3: return inner.precompose({ 0, -1, 0, 1, 0, 0 }, w, h);
+                    default: return inner;
+                }
+            }
+
+            template <SizedPlane T> static constexpr auto fold(draw::Repeat<T> const& plane) {
+                const auto inner = fold(plane.inner);
+                using Inner = std::remove_const_t<decltype(inner)>;
+                if constexpr (Inner::WRAPS) {
+                    // A repeat of a repeat is as far as it folds, the outer one is kept as is.
+                    return AffinePlane<draw::Repeat<Inner>> { draw::Repeat<Inner> { inner }, AffineMap {}, inner.width(), inner.height() };
+                } else {
+                    return AffinePlane<decltype(inner.inner), true> {
+                        inner.inner, inner.map, inner.width(), inner.height(), AffineMap {}, inner.width(), inner.height()
+                    };
+                }
+            }
+
+            template <SizedPlane T> constexpr auto operator()(T const& inner) const noexcept -> decltype(fold(inner)) {
+                return fold(inner);
+            }
+        };
+    }
+
+    /// Collapses a chain of slices, shifts, mirrors, rotations and repeats into a single AffinePlane,
+    /// for chains evaluated over many pixels like a scrolled and flipped background.
+    ///
+    /// Other adapters end the chain, everything inside them is left as it was.
+    constexpr adapt::Fuse fuse() noexcept {
+        return adapt::Fuse {};
+    }
+}
@@ -0,0 +1,193 @@
+// A rasterizer of solid shapes, for debug overlays drawing many of them every frame.
+//
+// Shapes are clipped to the target before anything else and then written as horizontal spans, a row at
+// a time for row targets. Unlike the lazy Rectangle and FilledRectangle planes nothing is evaluated per
+// pixel, and shapes far outside the target cost nothing but the clipping.
+//
+// Like lines and clearing, shapes overwrite the target with their color rather than blending.
+#pragma once
+#include <primitive>
+#include <algorithm>
+#include <array>
+#include <vector>
+#include "color.hpp"
+#include "plane.hpp"
+
+namespace draw {
+    namespace detail {
+        /// Edge functions multiply differences of i32 coordinates, which takes up to 66 bits.
+        using i128 = __int128;
+
+        constexpr auto floor_div(i128 lhs, i128 rhs) noexcept -> i128 {
+            const i128 quotient = lhs / rhs;
+            return quotient * rhs != lhs and (lhs < 0) != (rhs < 0) ? quotient - 1 : quotient;
+        }
+
+        constexpr auto ceil_div(i128 lhs, i128 rhs) noexcept -> i128 {
+            return -floor_div(-lhs, rhs);
+        }
+    }
+
+    namespace adapt {
+        struct FillRect final {
+            i32 x, y, w, h;
+            Color color;
+
+            template <SizedPlane T> constexpr T& operator()(T& self) const requires MutablePlane<T> {
+                const i32 x0 = std::max(x, 0), x1 = i32(std::min<i64>(i64(x) + w, self.width()));
+                const i32 y0 = std::max(y, 0), y1 = i32(std::min<i64>(i64(y) + h, self.height()));
+                if (x0 >= x1 or y0 >= y1) return self;
+
+                for (i32 row = y0; row < y1; row += 1) detail::fill_span(self, row, x0, x1, color);
+                detail::damage_region(self, x0, y0, x1 - x0, y1 - y0);
+                return self;
+            }
+        };
+
+        /// The outline of a rectangle, one pixel wide and inside its bounds.
+        struct StrokeRect final {
+            i32 x, y, w, h;
+            Color color;
+
+            template <SizedPlane T> constexpr T& operator()(T& self) const requires MutablePlane<T> {
+                if (w <= 0 or h <= 0 or x >= self.width() or y >= self.height()) return self;
+                if (w <= 2 or h <= 2) return self | FillRect { x, y, w, h, color };
+
+                // Edges past the target aren't drawn, which also keeps their coordinates within i32.
+                const i64 right = i64(x) + w - 1, bottom = i64(y) + h - 1;
+                self | FillRect { x, y, w, 1, color };
+                if (bottom < self.height()) self | FillRect { x, i32(bottom), w, 1, color };
+                self | FillRect { x, y + 1, 1, h - 2, color };
+                if (right < self.width()) self | FillRect { i32(right), y + 1, 1, h - 2, color };
+                return self;
+            }
+        };
+
+        /// A filled triangle covering the pixels whose centers are inside it.
+        ///
+        /// Pixel centers exactly on an edge belong to only one of two triangles sharing that edge, so meshes
+        /// of triangles cover every pixel exactly once.
+        struct FillTriangle final {
+            std::array<i32, 2> a, b, c;
+            Color color;
+
+            template <SizedPlane T> constexpr T& operator()(T& self) const requires MutablePlane<T> {
+                auto p0 = a, p1 = b, p2 = c;
+                // Every edge function is made positive inside by ordering the corners consistently.
+                using detail::i128;
+                const i128 area = i128(i64(p1[0]) - p0[0]) * (i64(p2[1]) - p0[1]) - i128(i64(p1[1]) - p0[1]) * (i64(p2[0]) - p0[0]);
+                if (area == 0) return self;
+                if (area < 0) std::swap(p1, p2);
+
+                const i32 y0 = std::max({ std::min({ p0[1], p1[1], p2[1] }), 0 });
+                const i32 y1 = i32(std::min<i64>(i64(std::max({ p0[1], p1[1], p2[1] })) + 1, self.height()));
+                const i32 bound_x0 = std::max({ std::min({ p0[0], p1[0], p2[0] }), 0 });
+                const i32 bound_x1 = i32(std::min<i64>(i64(std::max({ p0[0], p1[0], p2[0] })) + 1, self.width()));
+                if (y0 >= y1 or bound_x0 >= bound_x1) return self;
+
+                const std::array<std::array<std::array<i32, 2>, 2>, 3> edges {{ { p0, p1 }, { p1, p2 }, { p2, p0 } }};
+                i32 min_x = bound_x1, max_x = bound_x0, min_y = y1, max_y = y0;
+
+                for (i32 y = y0; y < y1; y += 1) {
+                    // Coordinates are doubled so pixel centers at half positions stay integers.
+                    const i64 center_y = 2 * i64(y) + 1;
+                    i64 x0 = bound_x0, x1 = bound_x1;
+
+                    for (const auto& [from, to] : edges) {
+                        const i64 ex = i64(to[0]) - from[0], ey = i64(to[1]) - from[1];
+                        // The edge function at doubled (X, Y) is ex * (Y - 2 * fy) - ey * (X - 2 * fx), linear in X.
+                        const i128 constant = i128(ex) * (center_y - 2 * i64(from[1])) + i128(ey) * 2 * i64(from[0]);
+                        const i64 slope = -ey;
+                        // Top left edges include centers on them, the others need a positive value.
+                        const i64 bias = ey > 0 or (ey == 0 and ex < 0) ? 0 : 1;
+
+                        if (slope == 0) {
+                            if (constant < bias) x1 = x0;
+                        } else if (slope > 0) {
+                            const i128 min_center = detail::ceil_div(bias - constant, slope);
+                            x0 = i64(std::max<i128>(x0, detail::ceil_div(min_center - 1, 2)));
+                        } else {
+                            const i128 max_center = detail::floor_div(constant - bias, -slope);
+                            x1 = i64(std::min<i128>(x1, detail::floor_div(max_center - 1, 2) + 1));
+                        }
+                    }
+
+                    if (x0 >= x1) continue;
+                    detail::fill_span(self, y, i32(x0), i32(x1), color);
+                    min_x = std::min(min_x, i32(x0));
+                    max_x = std::max(max_x, i32(x1));
+                    min_y = std::min(min_y, y);
+                    max_y = std::max(max_y, y + 1);
+                }
+
+                if (min_x < max_x) detail::damage_region(self, min_x, min_y, max_x - min_x, max_y - min_y);
+                return self;
+            }
+        };
+    }
+
+    constexpr adapt::FillRect fill_rect(i32 x, i32 y, i32 width, i32 height, Color color = color::WHITE) {
+        return adapt::FillRect { x, y, width, height, color };
+    }
+
+    constexpr adapt::StrokeRect stroke_rect(i32 x, i32 y, i32 width, i32 height, Color color = color::WHITE) {
+        return adapt::StrokeRect { x, y, width, height, color };
+    }
+
+    constexpr adapt::FillTriangle fill_triangle(i32 x0, i32 y0, i32 x1, i32 y1, i32 x2, i32 y2, Color color = color::WHITE) {
+        return adapt::FillTriangle { { x0, y0 }, { x1, y1 }, { x2, y2 }, color };
+    }
+
+    /// Collects shapes to draw them all at once, which keeps the code producing them, say walking a BVH,
+    /// apart from the target. A batch can be drawn any number of times and reused after `clear`.
+    ///
+    /// Drawn like an adapter, `target | batch`.
+    class ShapeBatch final {
+        struct Shape final {
+            enum class Kind : u8 { Line, FillRect, StrokeRect, FillTriangle } kind;
+            std::array<i32, 6> points;
+            Color color;
+        };
+
+        std::vector<Shape> shapes;
+
+      public:
+        void line(i32 x0, i32 y0, i32 x1, i32 y1, Color color = color::WHITE) {
+            shapes.push_back({ Shape::Kind::Line, { x0, y0, x1, y1 }, color });
+        }
+
+        void fill_rect(i32 x, i32 y, i32 width, i32 height, Color color = color::WHITE) {
+            shapes.push_back({ Shape::Kind::FillRect, { x, y, width, height }, color });
+        }
+
+        void stroke_rect(i32 x, i32 y, i32 width, i32 height, Color color = color::WHITE) {
+            shapes.push_back({ Shape::Kind::StrokeRect, { x, y, width, height }, color });
+        }
+
+        void fill_triangle(i32 x0, i32 y0, i32 x1, i32 y1, i32 x2, i32 y2, Color color = color::WHITE) {
+            shapes.push_back({ Shape::Kind::FillTriangle, { x0, y0, x1, y1, x2, y2 }, color });
+        }
+
+        auto size() const noexcept -> usize {
+            return shapes.size();
+        }
+
+        void clear() noexcept {
+            shapes.clear();
+        }
+
+        /// Draws the shapes in the order they were added.
+        template <SizedPlane T> T& operator()(T& self) const requires MutablePlane<T> {
+            for (Shape const& shape : shapes) {
+                const auto& [p0, p1, p2, p3, p4, p5] = shape.points;
+                switch (shape.kind) {
+                    case Shape::Kind::Line:         self | draw::line(p0, p1, p2, p3, shape.color);                break;
+                    case Shape::Kind::FillRect:     self | draw::fill_rect(p0, p1, p2, p3, shape.color);           break;
+                    case Shape::Kind::StrokeRect:   self | draw::stroke_rect(p0, p1, p2, p3, shape.color);         break;
+                    case Shape::Kind::FillTriangle: self | draw::fill_triangle(p0, p1, p2, p3, p4, p5, shape.color); break;
+                }
+            }
+            return self;
+        }
+    };
+}
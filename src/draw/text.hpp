@@ -5,11 +5,19 @@
 // It's not the most primitive however, that title belongs to the InfiniteImage.
 #pragma once
 #include <primitive>
+#include <algorithm>
+#include <array>
+#include <initializer_list>
+#include <memory>
 #include <string_view>
 #include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include "color.hpp"
 #include "plane.hpp"
 #include "image.hpp"
+#include "indexed.hpp"
 
 namespace draw {
     template <Plane T> struct Symbol final {
@@ -38,18 +46,104 @@ namespace draw {
     };
 
     template <Plane T, typename Chr> struct Font final {
+        /// Where symbols are within the source, so looking one up doesn't have to go through `map`.
+        struct Table final {
+            struct Entry final {
+                i32 x, y, width, height;
+                bool space;
+            };
+
+            std::array<Entry, 256> dense;
+            /// Characters past the dense range, sorted.
+            std::vector<std::pair<u32, Entry>> sparse;
+        };
+
         T source;
         i32 height;
         i32 baseline;
         i32 spacing;
         i32 leading;
         auto (*map) (T const&, Chr) -> Symbol<T>;
+        /// Shared so copying the font into a Text stays cheap.
+        std::shared_ptr<const Table> table {};
+
+      private:
+        auto symbol_of(typename Table::Entry const& entry) const -> Symbol<T> {
+            if (entry.space) return typename Symbol<T>::Space { entry.width };
+            return Slice<T>(source, entry.x, entry.y, entry.width, entry.height);
+        }
 
+      public:
         auto symbol(Chr c) const -> Symbol<T> {
+            if (table) {
+                const u32 code = u32(std::make_unsigned_t<Chr>(c));
+                if (code < table->dense.size()) return symbol_of(table->dense[code]);
+
+                const auto found = std::lower_bound(
+                    table->sparse.begin(), table->sparse.end(), code,
+                    [] (auto const& item, u32 code) { return item.first < code; }
+                );
+                if (found != table->sparse.end() and found->first == code) return symbol_of(found->second);
+            }
             return this->map(source, c);
         }
     };
 
+    /// Looks up the symbols of every character below 256 and of the listed ones past it ahead of time,
+    /// so `symbol` becomes a table lookup instead of a call through `map`, which usually slices a grid
+    /// in a large switch. Characters outside the table still go through `map`.
+    ///
+    /// The glyphs `map` returns must be slices of the font source itself, which is how fonts are defined.
+    template <Plane T, typename Chr> auto tabulate(Font<T, Chr> font, std::initializer_list<Chr> extra = {}) -> Font<T, Chr> {
+        using Table = typename Font<T, Chr>::Table;
+        using SymbolType = typename Symbol<T>::Type;
+
+        const auto entry_of = [&font] (Chr c) -> typename Table::Entry {
+            const auto symbol = font.map(font.source, c);
+            if (symbol.type == SymbolType::Space) return { 0, 0, symbol.width(), 0, true };
+            const auto [x, y] = symbol.glyph.origin();
+            return { x, y, symbol.glyph.width(), symbol.glyph.height(), false };
+        };
+
+        auto table = std::make_shared<Table>();
+        for (u32 code = 0; code < table->dense.size(); code += 1) {
+            table->dense[code] = entry_of(Chr(code));
+        }
+        for (const Chr c : extra) {
+            const u32 code = u32(std::make_unsigned_t<Chr>(c));
+            if (code >= table->dense.size()) table->sparse.emplace_back(code, entry_of(c));
+        }
+        std::sort(table->sparse.begin(), table->sparse.end(), [] (auto const& a, auto const& b) { return a.first < b.first; });
+
+        font.table = std::move(table);
+        return font;
+    }
+
+    namespace detail {
+        /// Draws a glyph over the target with its white pixels in the color.
+        ///
+        /// Glyphs of indexed sheets are recolored by swapping white palette entries, which costs the
+        /// size of the palette rather than a comparison per pixel.
+        template <typename U, Plane T> void draw_glyph(U& target, Slice<T> const& glyph, i32 x, i32 y, Color color) {
+            if constexpr (IndexedPlane<Slice<T>>) {
+                const std::span<const Color> source = glyph.palette();
+                std::array<Color, 256> swapped;
+                const usize count = std::min(source.size(), swapped.size());
+                for (usize i = 0; i < count; i += 1) swapped[i] = source[i] == color::WHITE ? color : source[i];
+
+                target | draw::draw(glyph | draw::recolor(std::span(swapped).first(count)), x, y, blend::overwrite);
+            } else {
+                target | draw::draw(
+                    glyph | draw::map([color] (Color c, i32 x, i32 y) -> Color {
+                        return c == color::WHITE ? color : c;
+                    }),
+                    x, y,
+                    blend::overwrite
+                );
+            }
+        }
+    }
+
     /// A drawable representing text.
     ///
     /// Notably this type performs caching to be remotely efficient while maintaining the composable
@@ -80,13 +174,7 @@ namespace draw {
                 auto sym = font.symbol(c);
                 switch (sym.type) {
                     case SymbolType::Glyph:
-                        ret | draw(
-                            sym.glyph | draw::map([this] (Color c, i32 x, i32 y) -> Color {
-                                return c == color::WHITE ? color : c;
-                            }),
-                            cursor, 0,
-                            blend::overwrite
-                        );
+                        detail::draw_glyph(ret, sym.glyph, cursor, 0, color);
 
                         cursor += sym.width() + font.spacing;
                         break;
@@ -128,5 +216,8 @@ namespace draw {
 
     template <typename T> Text(char const*, Font<T, char>, Color = color::WHITE) -> Text<T, std::string_view>;
 
+    /// Drawing text fills its cache on first use, which isn't synchronized.
+    template <Plane T, typename Str> constexpr bool disable_concurrent_get<Text<T, Str>> = true;
+
     static_assert(SizedPlane<Text<Image>>);
 }
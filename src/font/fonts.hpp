@@ -3,27 +3,88 @@
 #pragma once
 #include <draw>
 #include <io>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
 
 namespace font {
     using draw::Font;
     using draw::TgaImage;
-    using draw::Image;
+    using draw::BitImage;
+    using draw::IndexedImage;
     using draw::Ref;
 
-    inline auto sonic(Io& io) -> Font<Ref<const Image>, char> const& {
-        using Inner = Ref<const Image>;
+    #ifdef RAYTRACER_EMBED_RESOURCES
+    /// Font sheets decoded at compile time from the embedded resources.
+    namespace sheets {
+        using io::embedded::MINEFONT_TGA;
+        using io::embedded::PICOFONT_TGA;
+        using io::embedded::PODFONT_TGA;
+
+        inline constexpr auto MINEFONT =
+            draw::FixedImage<draw::tga_width(MINEFONT_TGA), draw::tga_height(MINEFONT_TGA)>::from_tga(MINEFONT_TGA);
+        inline constexpr auto PICOFONT =
+            draw::FixedImage<draw::tga_width(PICOFONT_TGA), draw::tga_height(PICOFONT_TGA)>::from_tga(PICOFONT_TGA);
+        inline constexpr auto PODFONT =
+            draw::FixedImage<draw::tga_width(PODFONT_TGA), draw::tga_height(PODFONT_TGA)>::from_tga(PODFONT_TGA);
+
+        template <typename T> auto image(T const& sheet) -> std::shared_ptr<const BitImage> {
+            return std::make_shared<const BitImage>(BitImage::from(sheet));
+        }
+
+        /// Each sheet is packed once on first use and shared by every font drawn from it.
+        inline auto find(std::string_view path) -> std::shared_ptr<const BitImage> {
+            if (path == "res/minefont.tga") {
+                static const auto minefont = image(MINEFONT);
+                return minefont;
+            }
+            if (path == "res/picofont.tga") {
+                static const auto picofont = image(PICOFONT);
+                return picofont;
+            }
+            if (path == "res/podfont.tga") {
+                static const auto podfont = image(PODFONT);
+                return podfont;
+            }
+            return nullptr;
+        }
+    }
+    #endif
+
+    /// Loads a monochrome TGA font sheet packed into a bit image through the shared asset cache, so
+    /// fonts using the same sheet share it and the packed image can be persisted between runs.
+    ///
+    /// When resources are embedded the bundled sheets are already decoded and only packed.
+    inline auto load_bits(Io& io, std::string_view path) -> std::shared_ptr<const BitImage> {
+        #ifdef RAYTRACER_EMBED_RESOURCES
+        if (auto sheet = sheets::find(path)) return sheet;
+        #endif
+        return io::AssetCache::shared().load<BitImage>(io, path, "tga-bits-v1", [] (std::span<const u8> data) {
+            return BitImage::from(TgaImage::decode(data));
+        });
+    }
+
+    /// Loads a TGA font sheet of up to 256 colors packed into an indexed image, like `load_bits`.
+    inline auto load_indexed(Io& io, std::string_view path) -> std::shared_ptr<const IndexedImage> {
+        return io::AssetCache::shared().load<IndexedImage>(io, path, "tga-indexed-v1", [] (std::span<const u8> data) {
+            return IndexedImage::from(TgaImage::decode(data));
+        });
+    }
+
+    inline auto sonic(Io& io) -> Font<Ref<const IndexedImage>, char> const& {
+        using Inner = Ref<const IndexedImage>;
         using Symbol = draw::Symbol<Inner>;
 
-        static auto sonicfont = TgaImage::from(io.read_file("res/sonicfont.tga"))
-            | draw::flatten<Image>();
+        static auto sonicfont = load_indexed(io, "res/sonicfont.tga");
 
-        static Font<Ref<const Image>, char> font = {
-            sonicfont, // source
+        static auto font = draw::tabulate(Font<Ref<const IndexedImage>, char> {
+            *sonicfont, // source
             10, // height
             0, // baseline
             2, // spacing
             1, // leading
-            [] (Ref<const Image> const& src, char c) -> Symbol {
+            [] (Ref<const IndexedImage> const& src, char c) -> Symbol {
                 const auto grid = src | draw::grid(9, 10);
 
                 switch (c) {
@@ -76,25 +137,24 @@ namespace font {
                     default: return grid.tile(0, 0).resize_right(-3);
                 }
             },
-        };
+        });
 
         return font;
     }
 
-    inline auto pico(Io& io) -> Font<Ref<const Image>, char> const& {
-        using Inner = Ref<const Image>;
+    inline auto pico(Io& io) -> Font<Ref<const BitImage>, char> const& {
+        using Inner = Ref<const BitImage>;
         using Symbol = draw::Symbol<Inner>;
 
-        static auto minefont = TgaImage::from(io.read_file("res/picofont.tga"))
-            | draw::flatten<Image>();
+        static auto minefont = load_bits(io, "res/picofont.tga");
 
-        static Font<Ref<const Image>, char> font = {
-            minefont, // source
+        static auto font = draw::tabulate(Font<Ref<const BitImage>, char> {
+            *minefont, // source
             5, // height
             0, // baseline
             1, // spacing
             1, // leading
-            [] (Ref<const Image> const& src, char c) -> Symbol {
+            [] (Ref<const BitImage> const& src, char c) -> Symbol {
                 const auto grid = src | draw::grid(3, 5);
 
                 switch (c) {
@@ -173,25 +233,24 @@ namespace font {
                     default: return Symbol::Space { 3 };
                 }
             },
-        };
+        });
 
         return font;
     }
 
-    inline auto mine(Io& io) -> Font<Ref<const Image>, char> const& {
-        using Inner = Ref<const Image>;
+    inline auto mine(Io& io) -> Font<Ref<const BitImage>, char> const& {
+        using Inner = Ref<const BitImage>;
         using Symbol = draw::Symbol<Inner>;
 
-        static auto minefont = TgaImage::from(io.read_file("res/minefont.tga"))
-            | draw::flatten<Image>();
+        static auto minefont = load_bits(io, "res/minefont.tga");
 
-        static Font<Ref<const Image>, char> font = {
-            minefont, // source
+        static auto font = draw::tabulate(Font<Ref<const BitImage>, char> {
+            *minefont, // source
             8, // height
             1, // baseline
             1, // spacing
             1, // leading
-            [] (Ref<const Image> const& src, char c) -> Symbol {
+            [] (Ref<const BitImage> const& src, char c) -> Symbol {
                 const auto grid = src | draw::grid(5, 8);
 
                 switch (c) {
@@ -327,25 +386,24 @@ namespace font {
                     default: return grid.tile(0, 0);
                 }
             },
-        };
+        });
 
         return font;
     }
 
-    inline auto mine_u16(Io& io) -> Font<Ref<const Image>, char16> const& {
-        using Inner = Ref<const Image>;
+    inline auto mine_u16(Io& io) -> Font<Ref<const BitImage>, char16> const& {
+        using Inner = Ref<const BitImage>;
         using Symbol = draw::Symbol<Inner>;
 
-        static auto minefont = TgaImage::from(io.read_file("res/minefont.tga"))
-            | draw::flatten<Image>();
+        static auto minefont = load_bits(io, "res/minefont.tga");
 
-        static Font<Ref<const Image>, char16> font = {
-            minefont, // source
+        static auto font = draw::tabulate(Font<Ref<const BitImage>, char16> {
+            *minefont, // source
             8, // height
             1, // baseline
             1, // spacing
             1, // leading
-            [] (Ref<const Image> const& src, char16 c) -> Symbol {
+            [] (Ref<const BitImage> const& src, char16 c) -> Symbol {
                 const auto grid = src | draw::grid(5, 8);
 
                 switch (c) {
@@ -481,25 +539,24 @@ namespace font {
                     default: return grid.tile(0, 0);
                 }
             },
-        };
+        }, { u'™', u'–', u'…', u'—' });
 
         return font;
     }
 
-    inline auto pod(Io& io) -> Font<Ref<const Image>, char> const& {
-        using Inner = Ref<const Image>;
+    inline auto pod(Io& io) -> Font<Ref<const BitImage>, char> const& {
+        using Inner = Ref<const BitImage>;
         using Symbol = draw::Symbol<Inner>;
 
-        static auto podfont = TgaImage::from(io.read_file("res/podfont.tga"))
-            | draw::flatten<Image>();
+        static auto podfont = load_bits(io, "res/podfont.tga");
 
-        static Font<Ref<const Image>, char> font = {
-            podfont, // source
+        static auto font = draw::tabulate(Font<Ref<const BitImage>, char> {
+            *podfont, // source
             12, // height
             3,  // baseline
             2,  // spacing
             1,  // leading
-            [] (Ref<const Image> const& src, char c) -> Symbol {
+            [] (Ref<const BitImage> const& src, char c) -> Symbol {
                 const auto grid = src | draw::grid(6, 12);
 
                 switch (c) {
@@ -609,7 +666,7 @@ namespace font {
                     default: return grid.tile(0, 0);
                 }
             },
-        };
+        });
 
         return font;
     }
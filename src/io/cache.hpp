@@ -0,0 +1,234 @@
+// A process wide cache of assets derived from files.
+//
+// Assets are looked up by path first, and on a miss the file is read and looked up again by the hash of its
+// contents, so the same data reachable through different paths, or the same file loaded by unrelated code,
+// is only ever decoded once and shared as an immutable handle.
+//
+// Derived data which knows how to serialize itself can additionally be persisted to a directory, keyed by
+// the kind of asset and the content hash, so a later run can skip decoding entirely as long as the source
+// file didn't change.
+#pragma once
+#include <primitive>
+#include <concepts>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "io.hpp"
+
+namespace io {
+    /// A fast, non-cryptographic 64-bit hash of the data.
+    ///
+    /// It's used to detect identical content, not to defend against anyone crafting collisions.
+    constexpr auto content_hash(std::span<const u8> data) noexcept -> u64 {
+        constexpr u64 PRIME = 0x9E3779B97F4A7C15;
+        u64 hash = 0xCBF29CE484222325 ^ (u64(data.size()) * PRIME);
+
+        const auto mix = [] (u64 x) -> u64 {
+            x ^= x >> 33;
+            x *= 0xFF51AFD7ED558CCD;
+            x ^= x >> 33;
+            x *= 0xC4CEB93FE53B2F53;
+            x ^= x >> 33;
+            return x;
+        };
+
+        usize i = 0;
+        for (; i + 8 <= data.size(); i += 8) {
+            u64 word = 0;
+            for (usize b = 0; b < 8; b += 1) word |= u64(data[i + b]) << (b * 8);
+            hash = (hash ^ mix(word)) * PRIME;
+        }
+
+        u64 tail = 0;
+        for (usize b = 0; i + b < data.size(); b += 1) tail |= u64(data[i + b]) << (b * 8);
+        return mix(hash ^ mix(tail));
+    }
+
+    /// An asset which can be written out and read back with the binary serialization primitives.
+    template <typename T> concept Persistent = requires (T const& value, BinaryWriter& writer, BinaryReader& reader) {
+        value.serialize(writer);
+        { T::deserialize(reader) } -> std::same_as<T>;
+    };
+
+    /// Deduplicates assets decoded from files and hands them out as shared immutable handles.
+    ///
+    /// Every load names the kind of asset it produces with a tag, which identifies both the type and the
+    /// encoding of persisted data, so it should be changed whenever either changes (hence "obj-mesh-v1").
+    /// Loading the same path under the same tag as a different type is an error, reported by throwing
+    /// `std::logic_error`.
+    ///
+    /// All operations are thread-safe, decoding happens outside of the lock.
+    class AssetCache final {
+        /// An asset along with the type it was stored as, which is checked on every lookup.
+        struct Entry final {
+            std::type_index type;
+            std::shared_ptr<const void> asset;
+        };
+
+        std::mutex lock;
+        /// Keyed by tag and path.
+        std::unordered_map<std::string, Entry> by_path;
+        /// Keyed by tag and content hash.
+        std::unordered_map<std::string, Entry> by_content;
+        std::optional<std::string> directory;
+
+      public:
+        struct Stats final {
+            /// Loads answered by path without touching the file.
+            usize path_hits { 0 };
+            /// Loads of a new path whose content was already decoded.
+            usize content_hits { 0 };
+            /// Loads answered from persisted data.
+            usize disk_hits { 0 };
+            /// Loads which had to decode.
+            usize decodes { 0 };
+        };
+
+      private:
+        Stats counters;
+
+        static auto path_key(std::string_view tag, std::string_view path) -> std::string {
+            auto ret = std::string(tag);
+            ret.push_back('\0');
+            ret.append(path);
+            return ret;
+        }
+
+        static auto content_key(std::string_view tag, u64 hash) -> std::string {
+            char hex[17];
+            std::snprintf(hex, sizeof(hex), "%016llx", (unsigned long long) hash);
+            return std::string(tag) + "-" + hex;
+        }
+
+        template <typename T> static auto cast(Entry const& entry) -> std::shared_ptr<const T> {
+            if (entry.type != std::type_index(typeid(T))) {
+                throw std::logic_error("AssetCache: an asset was loaded as two different types under the same tag");
+            }
+            return std::static_pointer_cast<const T>(entry.asset);
+        }
+
+        template <typename T> auto insert(std::string key, std::string path, std::shared_ptr<const T> asset)
+            -> std::shared_ptr<const T>
+        {
+            std::lock_guard guard { lock };
+            // Another thread could have decoded the same content while we were.
+            auto [it, inserted] = by_content.try_emplace(std::move(key), Entry { typeid(T), std::move(asset) });
+            auto ret = cast<T>(it->second);
+            by_path.insert_or_assign(std::move(path), it->second);
+            return ret;
+        }
+
+      public:
+        AssetCache() {}
+
+        AssetCache(AssetCache const&) = delete;
+        auto operator=(AssetCache const&) -> AssetCache& = delete;
+
+        /// The cache shared by the whole process.
+        static auto shared() -> AssetCache& {
+            static AssetCache instance;
+            return instance;
+        }
+
+        /// Enables persisting derived data to the directory, creating it if necessary.
+        /// Passing nothing disables persistence, already persisted files are left alone.
+        void persist_to(Io& io, std::optional<std::string> path) {
+            if (path) io.create_directory(*path);
+            std::lock_guard guard { lock };
+            directory = std::move(path);
+        }
+
+        /// Returns the asset derived from the file at the path, decoding it with the provided function of signature:
+        /// (data: std::span<const u8>) -> T
+        ///
+        /// Once a path is loaded it isn't read again until it's invalidated.
+        template <typename T, typename F> auto load(Io& io, std::string_view path, std::string_view tag, F decode)
+            -> std::shared_ptr<const T>
+        {
+            auto pkey = path_key(tag, path);
+            std::optional<std::string> persist;
+            {
+                std::lock_guard guard { lock };
+                if (auto it = by_path.find(pkey); it != by_path.end()) {
+                    counters.path_hits += 1;
+                    return cast<T>(it->second);
+                }
+                persist = directory;
+            }
+
+            const auto data = io.map_file(path);
+            const u64 hash = content_hash(data.data());
+            auto ckey = content_key(tag, hash);
+            {
+                std::lock_guard guard { lock };
+                if (auto it = by_content.find(ckey); it != by_content.end()) {
+                    auto ret = cast<T>(it->second);
+                    counters.content_hits += 1;
+                    by_path.insert_or_assign(pkey, it->second);
+                    return ret;
+                }
+            }
+
+            const auto file = persist ? std::optional(*persist + "/" + ckey + ".bin") : std::nullopt;
+
+            if constexpr (Persistent<T>) {
+                // Persisted data is only an optimization, if it's missing or unreadable decode as usual.
+                if (file) try {
+                    const auto persisted = io.read_file(*file);
+                    auto reader = BinaryReader::of(persisted);
+                    auto asset = std::make_shared<const T>(T::deserialize(reader));
+                    { std::lock_guard guard { lock }; counters.disk_hits += 1; }
+                    return insert<T>(std::move(ckey), std::move(pkey), std::move(asset));
+                } catch (Io::Error const&) {
+                } catch (std::out_of_range const&) {}
+            }
+
+            auto asset = std::make_shared<const T>(decode(data.data()));
+            { std::lock_guard guard { lock }; counters.decodes += 1; }
+
+            if constexpr (Persistent<T>) {
+                if (file) try {
+                    BinaryWriter writer;
+                    asset->serialize(writer);
+                    io.write_file(*file, writer.view());
+                } catch (Io::Error const&) {}
+            }
+
+            return insert<T>(std::move(ckey), std::move(pkey), std::move(asset));
+        }
+
+        /// Forgets the path so the next load reads it again, picking up any changes.
+        ///
+        /// Handles already given out remain valid, and unchanged content is still shared.
+        void invalidate(std::string_view path) {
+            std::lock_guard guard { lock };
+            std::erase_if(by_path, [path] (auto const& entry) {
+                auto const& key = entry.first;
+                const auto separator = key.find('\0');
+                return std::string_view(key).substr(separator + 1) == path;
+            });
+        }
+
+        /// Drops every asset held by the cache, handles already given out remain valid.
+        void clear() {
+            std::lock_guard guard { lock };
+            by_path.clear();
+            by_content.clear();
+        }
+
+        auto stats() -> Stats {
+            std::lock_guard guard { lock };
+            return counters;
+        }
+    };
+}
@@ -0,0 +1,76 @@
+// Resources embedded into the binary.
+//
+// Only present when building with RAYTRACER_EMBED_RESOURCES, in which case the build passes the resource
+// directory as an embed directory and `Io::read_file` answers paths under `res/` from here without
+// touching the disk, so the binary is self-contained.
+#pragma once
+#include <primitive>
+#include <optional>
+#include <span>
+#include <string_view>
+
+#ifdef RAYTRACER_EMBED_RESOURCES
+namespace io::embedded {
+    inline constexpr u8 MINEFONT_TGA[] = {
+        #embed <minefont.tga>
+    };
+
+    inline constexpr u8 PICOFONT_TGA[] = {
+        #embed <picofont.tga>
+    };
+
+    inline constexpr u8 PODFONT_TGA[] = {
+        #embed <podfont.tga>
+    };
+
+    inline constexpr u8 HIGHERPOLY_BUNNY_OBJ[] = {
+        #embed <higherpoly_bunny.obj>
+    };
+
+    inline constexpr u8 LOWPOLY_BUNNY_OBJ[] = {
+        #embed <lowpoly_bunny.obj>
+    };
+
+    inline constexpr u8 SMOOTH_BUNNY_OBJ[] = {
+        #embed <smooth_bunny.obj>
+    };
+
+    inline constexpr u8 SIMPLE_CUBE_OBJ[] = {
+        #embed <simple_cube.obj>
+    };
+
+    inline constexpr u8 SIMPLE_OBJECT_OBJ[] = {
+        #embed <simple_object.obj>
+    };
+
+    inline constexpr u8 SIMPLE_QUAD_OBJ[] = {
+        #embed <simple_quad.obj>
+    };
+
+    struct Resource final {
+        std::string_view path;
+        std::span<const u8> data;
+    };
+
+    inline constexpr Resource RESOURCES[] = {
+        { "res/minefont.tga", MINEFONT_TGA },
+        { "res/picofont.tga", PICOFONT_TGA },
+        { "res/podfont.tga", PODFONT_TGA },
+        { "res/higherpoly_bunny.obj", HIGHERPOLY_BUNNY_OBJ },
+        { "res/lowpoly_bunny.obj", LOWPOLY_BUNNY_OBJ },
+        { "res/smooth_bunny.obj", SMOOTH_BUNNY_OBJ },
+        { "res/simple_cube.obj", SIMPLE_CUBE_OBJ },
+        { "res/simple_object.obj", SIMPLE_OBJECT_OBJ },
+        { "res/simple_quad.obj", SIMPLE_QUAD_OBJ },
+    };
+
+    /// Returns the embedded contents of the resource at the path, if it was embedded.
+    constexpr auto find(std::string_view path) noexcept -> std::optional<std::span<const u8>> {
+        if (path.starts_with("./")) path.remove_prefix(2);
+        for (auto const& resource : RESOURCES) {
+            if (resource.path == path) return resource.data;
+        }
+        return std::nullopt;
+    }
+}
+#endif
@@ -3,8 +3,15 @@
 #pragma once
 #include <primitive>
 #include <string_view>
+#include <string>
 #include <vector>
-// #include <span>
+#include <span>
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include "embedded.hpp"
 
 /// Encapsulates all global side effects.
 ///
@@ -36,6 +43,20 @@ class Io {
     virtual auto perform_open_library(char const* path) -> void* = 0;
     virtual void perform_close_library(void* library) = 0;
     virtual auto perform_load_symbol(void* library, char const* name) -> void* = 0;
+    virtual void perform_write_file(char const* path, std::span<const u8> data) = 0;
+    virtual auto perform_open_file(char const* path) -> void* = 0;
+    virtual void perform_close_file(void* file) = 0;
+    virtual auto perform_file_size(void* file) -> u64 = 0;
+    virtual void perform_read_file_at(void* file, u64 offset, std::span<u8> out) = 0;
+    virtual void perform_create_directory(char const* path) = 0;
+    virtual auto perform_open_output(char const* path) -> void* = 0;
+    virtual void perform_write_output(void* output, std::span<const u8> data) = 0;
+    virtual void perform_flush_output(void* output) = 0;
+    virtual void perform_close_output(void* output) = 0;
+    virtual auto perform_map_shared_memory(char const* name, usize size) -> void* = 0;
+    virtual void perform_unmap_shared_memory(char const* name, void* data, usize size) = 0;
+    virtual auto perform_map_file(char const* path, usize& size) -> void const* = 0;
+    virtual void perform_unmap_file(void const* data, usize size) = 0;
 
   public:
     Io(Io const&) = delete;
@@ -86,153 +107,383 @@ class Io {
         return DynamicLibrary(*this, perform_open_library(path.data()));
     }
 
+    /// A file opened for random access reads.
+    ///
+    /// Unlike `read_file` this never holds the whole file in memory, only what is explicitly read out of it.
+    /// Reads are positional and safe to perform concurrently from multiple threads.
+    class File final {
+        Io& io;
+        void* obj;
+
+        File(Io& io, void* obj) : io(io), obj(obj) {}
+
+        friend class Io;
+
+      public:
+        File(File const&) = delete;
+        auto operator=(File const&) -> File& = delete;
+
+        File(File&& other) noexcept : io(other.io), obj(other.obj) {
+            other.obj = nullptr;
+        }
+
+        auto operator=(File&& other) noexcept -> File& {
+            if (this != &other) {
+                if (obj) io.perform_close_file(obj);
+                obj = other.obj;
+                other.obj = nullptr;
+            }
+            return *this;
+        }
+
+        ~File() noexcept {
+            if (obj) {
+                io.perform_close_file(obj);
+                obj = nullptr;
+            }
+        }
+
+        auto size() const -> u64 {
+            return io.perform_file_size(obj);
+        }
+
+        /// Fills the provided buffer with the bytes starting at the offset.
+        /// Reading past the end of the file is an error.
+        void read(u64 offset, std::span<u8> out) const {
+            io.perform_read_file_at(obj, offset, out);
+        }
+    };
+
+    auto open_file(std::string_view path) [[clang::lifetimebound]] -> File {
+        return File(*this, perform_open_file(path.data()));
+    }
+
+    /// A sequential output stream, such as a file being written, a FIFO or the standard output.
+    ///
+    /// Unlike `write_file` the data doesn't have to be known up front, it's written as it's produced.
+    class Output final {
+        Io& io;
+        void* obj;
+
+        Output(Io& io, void* obj) : io(io), obj(obj) {}
+
+        friend class Io;
+
+      public:
+        Output(Output const&) = delete;
+        auto operator=(Output const&) -> Output& = delete;
+
+        Output(Output&& other) noexcept : io(other.io), obj(other.obj) {
+            other.obj = nullptr;
+        }
+
+        auto operator=(Output&& other) noexcept -> Output& {
+            if (this != &other) {
+                if (obj) io.perform_close_output(obj);
+                obj = other.obj;
+                other.obj = nullptr;
+            }
+            return *this;
+        }
+
+        ~Output() noexcept {
+            if (obj) {
+                io.perform_close_output(obj);
+                obj = nullptr;
+            }
+        }
+
+        /// Writes all of the data, blocking until it's been accepted.
+        void write(std::span<const u8> data) const {
+            io.perform_write_output(obj, data);
+        }
+
+        void flush() const {
+            io.perform_flush_output(obj);
+        }
+    };
+
+    /// Opens an output stream at the path, truncating any existing file. The path "-" is the standard output.
+    auto open_output(std::string_view path) [[clang::lifetimebound]] -> Output {
+        return Output(*this, perform_open_output(path.data()));
+    }
+
+    /// A named shared memory segment mapped into this process, visible to other local processes
+    /// which map the same name. It's zero initialized when created and removed once unmapped.
+    class SharedMemory final {
+        Io& io;
+        std::string name;
+        void* obj;
+        usize length;
+
+        SharedMemory(Io& io, std::string name, void* obj, usize length)
+            : io(io), name(std::move(name)), obj(obj), length(length) {}
+
+        friend class Io;
+
+      public:
+        SharedMemory(SharedMemory const&) = delete;
+        auto operator=(SharedMemory const&) -> SharedMemory& = delete;
+
+        SharedMemory(SharedMemory&& other) noexcept
+            : io(other.io), name(std::move(other.name)), obj(other.obj), length(other.length)
+        {
+            other.obj = nullptr;
+        }
+
+        auto operator=(SharedMemory&& other) noexcept -> SharedMemory& {
+            if (this != &other) {
+                if (obj) io.perform_unmap_shared_memory(name.c_str(), obj, length);
+                name = std::move(other.name);
+                obj = other.obj;
+                length = other.length;
+                other.obj = nullptr;
+            }
+            return *this;
+        }
+
+        ~SharedMemory() noexcept {
+            if (obj) {
+                io.perform_unmap_shared_memory(name.c_str(), obj, length);
+                obj = nullptr;
+            }
+        }
+
+        auto data() const noexcept -> u8* {
+            return (u8*) obj;
+        }
+
+        auto size() const noexcept -> usize {
+            return length;
+        }
+    };
+
+    /// Creates a shared memory segment of the given size, replacing any existing one with the name.
+    /// Names follow POSIX conventions, a leading slash and no other slashes.
+    auto create_shared_memory(std::string_view name, usize size) [[clang::lifetimebound]] -> SharedMemory {
+        auto owned = std::string(name);
+        const auto data = perform_map_shared_memory(owned.c_str(), size);
+        return SharedMemory(*this, std::move(owned), data, size);
+    }
+
+    /// The read-only contents of a whole file.
+    ///
+    /// Where the platform allows it the file is mapped into memory rather than read, so nothing is
+    /// copied until the pages are actually touched.
+    class MappedFile final {
+        Io* io;
+        void const* obj;
+        usize length;
+
+        MappedFile(Io* io, void const* obj, usize length) : io(io), obj(obj), length(length) {}
+
+        friend class Io;
+
+      public:
+        MappedFile(MappedFile const&) = delete;
+        auto operator=(MappedFile const&) -> MappedFile& = delete;
+
+        MappedFile(MappedFile&& other) noexcept : io(other.io), obj(other.obj), length(other.length) {
+            other.io = nullptr;
+        }
+
+        auto operator=(MappedFile&& other) noexcept -> MappedFile& {
+            if (this != &other) {
+                if (io) io->perform_unmap_file(obj, length);
+                io = other.io;
+                obj = other.obj;
+                length = other.length;
+                other.io = nullptr;
+            }
+            return *this;
+        }
+
+        ~MappedFile() noexcept {
+            if (io) {
+                io->perform_unmap_file(obj, length);
+                io = nullptr;
+            }
+        }
+
+        auto data() const noexcept -> std::span<const u8> {
+            return { (u8 const*) obj, length };
+        }
+
+        operator std::span<const u8>() const noexcept {
+            return data();
+        }
+    };
+
+    /// Maps the whole file, or refers to the embedded copy of a bundled resource if it was built in.
+    auto map_file(std::string_view path) [[clang::lifetimebound]] -> MappedFile {
+        #ifdef RAYTRACER_EMBED_RESOURCES
+        if (const auto embedded = io::embedded::find(path)) return MappedFile(nullptr, embedded->data(), embedded->size());
+        #endif
+        usize size = 0;
+        const auto data = perform_map_file(path.data(), size);
+        return MappedFile(this, data, size);
+    }
+
+    /// Reads the whole file, or returns the embedded copy of a bundled resource if it was built in.
     auto read_file(std::string_view path) -> std::vector<u8> {
+        #ifdef RAYTRACER_EMBED_RESOURCES
+        if (const auto embedded = io::embedded::find(path)) return std::vector(embedded->begin(), embedded->end());
+        #endif
         return perform_read_file(path.data());
     }
+
+    /// Writes the data to the file at the given path, replacing it if it exists.
+    void write_file(std::string_view path, std::span<const u8> data) {
+        perform_write_file(path.data(), data);
+    }
+
+    /// Creates the directory along with any missing parents, succeeding if it already exists.
+    void create_directory(std::string_view path) {
+        perform_create_directory(path.data());
+    }
 };
 
-// namespace io {
-//     class BinaryWriter final {};
-
-//     /// A sound implementation of a binary data reader for serialization purposes.
-//     ///
-//     /// It reads data out by individual bytes so alignment is not relevant,
-//     /// among other workarounds to avoid undefined behavior.
-//     class BinaryReader final {
-//         std::span<const u8> data;
-//         usize cursor { 0 };
-
-//         BinaryReader(std::span<const u8> data [[clang::lifetimebound]]) : data(data) {}
-
-//       public:
-//         /// Returns a new, default reader for the given data.
-//         static auto of(std::span<const u8> data [[clang::lifetimebound]]) -> BinaryReader {
-//             return BinaryReader(data);
-//         }
-
-//         template <typename R> auto read() noexcept(noexcept(R::read(*this))) -> R {
-//             return R::read(*this);
-//         }
-
-//         auto u8() -> ::u8 {
-//             const auto ret = this->data.at(this->cursor);
-//             this->cursor += 1;
-//             return ret;
-//         }
-
-//         auto u16() -> ::u16 {
-//             const auto ret = endian::from_le_bytes<::u16>(
-//                 this->data.at(this->cursor),
-//                 this->data.at(this->cursor + 1)
-//             );
-//             this->cursor += 2;
-//             return ret;
-//         }
-
-//         auto u32() -> ::u32 {
-//             const auto ret = endian::from_le_bytes<::u32>(
-//                 this->data.at(this->cursor),
-//                 this->data.at(this->cursor + 1),
-//                 this->data.at(this->cursor + 2),
-//                 this->data.at(this->cursor + 3)
-//             );
-//             this->cursor += 4;
-//             return ret;
-//         }
-
-//         auto u64() -> ::u64 {
-//             const auto ret = endian::from_le_bytes<::u64>(
-//                 this->data.at(this->cursor),
-//                 this->data.at(this->cursor + 1),
-//                 this->data.at(this->cursor + 2),
-//                 this->data.at(this->cursor + 3),
-//                 this->data.at(this->cursor + 4),
-//                 this->data.at(this->cursor + 5),
-//                 this->data.at(this->cursor + 6),
-//                 this->data.at(this->cursor + 7)
-//             );
-//             this->cursor += 8;
-//             return ret;
-//         }
-
-//         auto i8() -> ::i8 {
-//             return *reinterpret_cast<::i8 const*>(&this->data.at(this->cursor));
-//         }
-
-//         auto i16() -> ::i16 {
-//             const auto ret = endian::from_le_bytes<::i16>(
-//                 this->data.at(this->cursor),
-//                 this->data.at(this->cursor + 1)
-//             );
-//             this->cursor += 2;
-//             return ret;
-//         }
-
-//         auto i32() -> ::i32 {
-//             const auto ret = endian::from_le_bytes<::i32>(
-//                 this->data.at(this->cursor),
-//                 this->data.at(this->cursor + 1),
-//                 this->data.at(this->cursor + 2),
-//                 this->data.at(this->cursor + 3)
-//             );
-//             this->cursor += 4;
-//             return ret;
-//         }
-
-//         auto i64() -> ::i64 {
-//             const auto ret = endian::from_le_bytes<::i64>(
-//                 this->data.at(this->cursor),
-//                 this->data.at(this->cursor + 1),
-//                 this->data.at(this->cursor + 2),
-//                 this->data.at(this->cursor + 3),
-//                 this->data.at(this->cursor + 4),
-//                 this->data.at(this->cursor + 5),
-//                 this->data.at(this->cursor + 6),
-//                 this->data.at(this->cursor + 7)
-//             );
-//             this->cursor += 8;
-//             return ret;
-//         }
-
-//         auto boolean() -> bool {
-//             const bool ret = this->data.at(this->cursor) ? true : false;
-//             this->cursor += 1;
-//             return ret;
-//         }
-
-//         /// Assume the current position to be a C string in a fixed buffer.
-//         /// Returns the C string and skips over the buffer.
-//         auto cstr(usize bufsize) -> char const* {
-//             // This cast is sound: u8 -> char (on arm architectures char is even already unsigned by default)
-//             // The alignment is a match.
-//             auto ret = reinterpret_cast<char const*>(&this->data.at(this->cursor));
-//             this->cursor += bufsize;
-//             return ret;
-//         }
-
-//         /// Returns the amount of data contained.
-//         auto size() const noexcept -> usize {
-//             return this->data.size();
-//         }
-
-//         /// Returns the current cursor offset.
-//         auto position() const noexcept -> usize {
-//             return this->cursor;
-//         }
-
-//         /// Resets the reader state to the start.
-//         void rewind() noexcept {
-//             this->cursor = 0;
-//         }
-
-//         /// Seeks to the specified byte position.
-//         void seek(usize position) noexcept {
-//             this->cursor = position;
-//         }
-
-//         /// Skips over the given number of bytes.
-//         void skip(usize count) noexcept {
-//             this->cursor += count;
-//         }
-//     };
-// }
+// Binary data is read and written as plain copies, which is only little endian on little endian hosts.
+static_assert(std::endian::native == std::endian::little);
+
+namespace io {
+    /// A growable binary buffer for serialization purposes.
+    ///
+    /// Values are written as their little endian byte representation.
+    class BinaryWriter final {
+        std::vector<::u8> data;
+
+        template <typename T> void put(T value) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            ::u8 bytes[sizeof(T)];
+            std::memcpy(bytes, &value, sizeof(T));
+            data.insert(data.end(), bytes, bytes + sizeof(T));
+        }
+
+      public:
+        BinaryWriter() {}
+
+        void u8(::u8 value) { put(value); }
+        void u16(::u16 value) { put(value); }
+        void u32(::u32 value) { put(value); }
+        void u64(::u64 value) { put(value); }
+        void i8(::i8 value) { put(value); }
+        void i16(::i16 value) { put(value); }
+        void i32(::i32 value) { put(value); }
+        void i64(::i64 value) { put(value); }
+        void f32(::f32 value) { put(value); }
+        void f64(::f64 value) { put(value); }
+
+        void boolean(bool value) {
+            put(::u8(value ? 1 : 0));
+        }
+
+        /// Appends raw bytes as they are.
+        void bytes(std::span<const ::u8> bytes) {
+            data.insert(data.end(), bytes.begin(), bytes.end());
+        }
+
+        /// Reserves space for at least the given number of additional bytes.
+        void reserve(usize count) {
+            data.reserve(data.size() + count);
+        }
+
+        /// Returns the amount of data written.
+        auto size() const noexcept -> usize {
+            return data.size();
+        }
+
+        auto view() const noexcept -> std::span<const ::u8> {
+            return data;
+        }
+
+        auto into_inner() && -> std::vector<::u8> {
+            return std::move(data);
+        }
+    };
+
+    /// A sound implementation of a binary data reader for serialization purposes.
+    ///
+    /// It reads data out by copying individual bytes so alignment is not relevant,
+    /// among other workarounds to avoid undefined behavior.
+    ///
+    /// Reading past the end of the data throws `std::out_of_range`.
+    class BinaryReader final {
+        std::span<const ::u8> data;
+        usize cursor { 0 };
+
+        BinaryReader(std::span<const ::u8> data [[clang::lifetimebound]]) : data(data) {}
+
+        template <typename T> auto take() -> T {
+            static_assert(std::is_trivially_copyable_v<T>);
+            if (sizeof(T) > data.size() - std::min(cursor, data.size())) throw std::out_of_range("BinaryReader");
+            T ret;
+            std::memcpy(&ret, data.data() + cursor, sizeof(T));
+            cursor += sizeof(T);
+            return ret;
+        }
+
+      public:
+        /// Returns a new, default reader for the given data.
+        static auto of(std::span<const ::u8> data [[clang::lifetimebound]]) -> BinaryReader {
+            return BinaryReader(data);
+        }
+
+        template <typename R> auto read() noexcept(noexcept(R::read(*this))) -> R {
+            return R::read(*this);
+        }
+
+        auto u8() -> ::u8 { return take<::u8>(); }
+        auto u16() -> ::u16 { return take<::u16>(); }
+        auto u32() -> ::u32 { return take<::u32>(); }
+        auto u64() -> ::u64 { return take<::u64>(); }
+        auto i8() -> ::i8 { return take<::i8>(); }
+        auto i16() -> ::i16 { return take<::i16>(); }
+        auto i32() -> ::i32 { return take<::i32>(); }
+        auto i64() -> ::i64 { return take<::i64>(); }
+        auto f32() -> ::f32 { return take<::f32>(); }
+        auto f64() -> ::f64 { return take<::f64>(); }
+
+        auto boolean() -> bool {
+            return take<::u8>() ? true : false;
+        }
+
+        /// Returns a view of the next `count` bytes and skips over them.
+        auto bytes(usize count) -> std::span<const ::u8> {
+            if (count > data.size() - std::min(cursor, data.size())) throw std::out_of_range("BinaryReader");
+            const auto ret = data.subspan(cursor, count);
+            cursor += count;
+            return ret;
+        }
+
+        /// Returns the amount of data contained.
+        auto size() const noexcept -> usize {
+            return this->data.size();
+        }
+
+        /// Returns the amount of data left to read.
+        auto remaining() const noexcept -> usize {
+            return data.size() - std::min(cursor, data.size());
+        }
+
+        /// Returns the current cursor offset.
+        auto position() const noexcept -> usize {
+            return this->cursor;
+        }
+
+        /// Resets the reader state to the start.
+        void rewind() noexcept {
+            this->cursor = 0;
+        }
+
+        /// Seeks to the specified byte position.
+        void seek(usize position) noexcept {
+            this->cursor = position;
+        }
+
+        /// Skips over the given number of bytes.
+        void skip(usize count) noexcept {
+            this->cursor += count;
+        }
+    };
+}
@@ -0,0 +1,212 @@
+// An implementation of Io in terms of POSIX, for machines without a display or SDL.
+#pragma once
+#ifndef _WIN32
+#include <primitive>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "io.hpp"
+
+/// An implementation of Io directly on top of the operating system.
+///
+/// Files are read with plain reads, or mapped when only viewed, positional reads use pread so they're
+/// safe to perform concurrently, and libraries are loaded with dlopen.
+class PosixIo final : public Io {
+    class Error final : public Io::Error, public std::exception {
+        std::string reason;
+      public:
+        /// A code of zero means the subject already describes the failure.
+        Error(std::string_view operation, std::string_view subject, int code = errno)
+            : reason(std::string(operation) + " " + std::string(subject))
+        {
+            if (code != 0) reason += std::string(": ") + std::strerror(code);
+        }
+
+        const char * what() const noexcept override {
+            return reason.c_str();
+        }
+    };
+
+    /// Closes the descriptor when leaving the scope.
+    struct Descriptor final {
+        int fd;
+
+        ~Descriptor() noexcept {
+            if (fd >= 0) close(fd);
+        }
+    };
+
+    static void write_all(int fd, std::span<const u8> data, char const* subject) {
+        while (not data.empty()) {
+            const auto written = write(fd, data.data(), data.size());
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                throw Error("write", subject);
+            }
+            data = data.subspan(usize(written));
+        }
+    }
+
+    static auto size_of(int fd, char const* subject) -> usize {
+        struct stat info;
+        if (fstat(fd, &info) != 0) throw Error("stat", subject);
+        return usize(info.st_size);
+    }
+
+    auto perform_read_file(char const* path) -> std::vector<u8> override {
+        const auto file = Descriptor { open(path, O_RDONLY | O_CLOEXEC) };
+        if (file.fd < 0) throw Error("open", path);
+
+        std::vector<u8> ret(size_of(file.fd, path));
+        usize cursor = 0;
+        while (cursor < ret.size()) {
+            const auto count = read(file.fd, ret.data() + cursor, ret.size() - cursor);
+            if (count < 0) {
+                if (errno == EINTR) continue;
+                throw Error("read", path);
+            }
+            if (count == 0) break;
+            cursor += usize(count);
+        }
+        ret.resize(cursor);
+        return ret;
+    }
+
+    auto perform_open_library(char const* path) -> void* override {
+        const auto ret = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+        if (not ret) throw Error("dlopen", dlerror(), 0);
+        return ret;
+    }
+
+    void perform_close_library(void* library) override {
+        dlclose(library);
+    }
+
+    auto perform_load_symbol(void* library, char const* name) -> void* override {
+        const auto ret = dlsym(library, name);
+        if (not ret) throw Error("dlsym", name, 0);
+        return ret;
+    }
+
+    void perform_write_file(char const* path, std::span<const u8> data) override {
+        const auto file = Descriptor { open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644) };
+        if (file.fd < 0) throw Error("open", path);
+        write_all(file.fd, data, path);
+    }
+
+    auto perform_open_file(char const* path) -> void* override {
+        const int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) throw Error("open", path);
+        return new int(fd);
+    }
+
+    void perform_close_file(void* file) override {
+        close(*(int*) file);
+        delete (int*) file;
+    }
+
+    auto perform_file_size(void* file) -> u64 override {
+        return size_of(*(int*) file, "file");
+    }
+
+    void perform_read_file_at(void* file, u64 offset, std::span<u8> out) override {
+        const int fd = *(int*) file;
+        while (not out.empty()) {
+            const auto count = pread(fd, out.data(), out.size(), off_t(offset));
+            if (count < 0) {
+                if (errno == EINTR) continue;
+                throw Error("pread", "file");
+            }
+            if (count == 0) throw Error("pread", "file", EIO);
+            out = out.subspan(usize(count));
+            offset += u64(count);
+        }
+    }
+
+    void perform_create_directory(char const* path) override {
+        auto partial = std::string(path);
+        // Create every parent in turn, the ones that exist already are fine.
+        for (usize i = 1; i <= partial.size(); i += 1) {
+            if (i != partial.size() and partial[i] != '/') continue;
+            const char saved = partial[i];
+            partial[i] = '\0';
+            if (mkdir(partial.c_str(), 0755) != 0 and errno != EEXIST) throw Error("mkdir", partial.c_str());
+            partial[i] = saved;
+        }
+    }
+
+    auto perform_open_output(char const* path) -> void* override {
+        const int fd = std::string_view(path) == "-"
+            ? dup(STDOUT_FILENO)
+            : open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) throw Error("open", path);
+        return new int(fd);
+    }
+
+    void perform_write_output(void* output, std::span<const u8> data) override {
+        write_all(*(int*) output, data, "output");
+    }
+
+    void perform_flush_output(void* output) override {
+        // Writes go straight to the descriptor, there is nothing buffered to flush.
+    }
+
+    void perform_close_output(void* output) override {
+        close(*(int*) output);
+        delete (int*) output;
+    }
+
+    auto perform_map_shared_memory(char const* name, usize size) -> void* override {
+        shm_unlink(name);
+        const auto segment = Descriptor { shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600) };
+        if (segment.fd < 0) throw Error("shm_open", name);
+        if (ftruncate(segment.fd, off_t(size)) != 0) {
+            const int code = errno;
+            shm_unlink(name);
+            throw Error("ftruncate", name, code);
+        }
+        const auto data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, segment.fd, 0);
+        if (data == MAP_FAILED) {
+            const int code = errno;
+            shm_unlink(name);
+            throw Error("mmap", name, code);
+        }
+        return data;
+    }
+
+    void perform_unmap_shared_memory(char const* name, void* data, usize size) override {
+        munmap(data, size);
+        shm_unlink(name);
+    }
+
+    auto perform_map_file(char const* path, usize& size) -> void const* override {
+        const auto file = Descriptor { open(path, O_RDONLY | O_CLOEXEC) };
+        if (file.fd < 0) throw Error("open", path);
+
+        size = size_of(file.fd, path);
+        // Mapping nothing is an error, but an empty file is not.
+        if (size == 0) return nullptr;
+
+        const auto data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file.fd, 0);
+        if (data == MAP_FAILED) throw Error("mmap", path);
+        return data;
+    }
+
+    void perform_unmap_file(void const* data, usize size) override {
+        if (data) munmap((void*) data, size);
+    }
+
+  public:
+    PosixIo() {}
+};
+#endif
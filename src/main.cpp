@@ -3,12 +3,20 @@
 #include <draw>
 #include <io>
 #include <rt>
+#include <cerrno>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
 
 class RayTracer final {
     raytracer::World world;
     bool show_info { true };
     bool show_hud { true };
     raytracer::World::Ref<raytracer::Mesh> bunny;
+    /// Drawing is const but the HUD is only rendered again when its text changes.
+    mutable rt::Overlay hud;
 
   public:
     RayTracer() {}
@@ -77,6 +85,8 @@ class RayTracer final {
         if (input.key_pressed(rt::Key::U)) world.set_shadows(not world.get_shadows());
         if (input.key_pressed(rt::Key::Y)) world.cycle_bsdf_mode();
         if (input.key_pressed(rt::Key::T)) world.cycle_gi_mode();
+        if (input.key_pressed(rt::Key::H))
+            world.set_tone_map(world.get_tone_map() ? std::nullopt : std::optional(draw::ToneMap {}));
 
         if (input.key_pressed(rt::Key::Num6)) show_hud = not show_hud;
         if (input.key_pressed(rt::Key::Num7)) show_info = not show_info;
@@ -112,7 +122,7 @@ class RayTracer final {
             std::stringstream out;
             out << "6: toggle hud" << std::endl
                 << "7: toggle info" << std::endl
-                << "8: toggle rate lock" << std::endl
+                << "8: toggle fixed step pacing" << std::endl
                 << "9: toggle performance overlay" << std::endl
                 << "0: toggle vsync" << std::endl
                 << "+/-: adjust target scale" << std::endl
@@ -121,6 +131,7 @@ class RayTracer final {
                 << "U: toggle shadows" << std::endl
                 << "Y: cycle BSDF debug modes" << std::endl
                 << "T: cycle BSDF GI modes" << std::endl
+                << "H: toggle tone mapping" << std::endl
                 << "W/S/A/D: move camera" << std::endl
                 << "Up/Down/Left/Right: rotate camera" << std::endl;
 
@@ -133,15 +144,82 @@ class RayTracer final {
                     << "GI mode: " << world.get_gi_mode() << std::endl;
             }
 
-            std::string line;
-            for (i32 y = 8; std::getline(out, line); y += font::mine(io).height + font::mine(io).leading) {
-                target | draw::draw(draw::Text(line, font::mine(io)), 8, y);
-            }
+            hud.set(out.str(), font::mine(io));
+            hud.composite(target, 8, 8);
         }
     }
 };
 
-auto main() -> i32 {
+auto main(i32 argc, char** argv) -> i32 {
     RayTracer instance;
-    rt::run(instance, "RayTracer", 4);
+
+    // Options come in pairs:
+    // `--headless <frames>` renders a fixed number of frames without a window,
+    // `--shm <name>` publishes the frames to a shared memory ring, instead of the window when headless,
+    // `--record <path>` records the input to a log and `--replay <path>` plays one back.
+    std::optional<usize> headless_frames;
+    std::optional<std::string> shm_name;
+    rt::InputLog log;
+    const auto usage = [&] {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--headless <frames>] [--shm <name>] [--record <path>] [--replay <path>]" << std::endl;
+        return 2;
+    };
+    for (i32 i = 1; i < argc; i += 2) {
+        const auto option = std::string_view(argv[i]);
+        if (i + 1 == argc) return usage();
+        char const* value = argv[i + 1];
+
+        if (option == "--headless") {
+            char* end = nullptr;
+            errno = 0;
+            const auto frames = std::strtoull(value, &end, 10);
+            if (end == value or *end != '\0' or errno == ERANGE or value[0] == '-') return usage();
+            headless_frames = usize(frames);
+        } else if (option == "--shm") {
+            #ifdef _WIN32
+            std::cerr << "Shared memory output is not supported on this platform" << std::endl;
+            return 2;
+            #else
+            shm_name = value;
+            #endif
+        } else if (option == "--record") {
+            log.record = value;
+        } else if (option == "--replay") {
+            log.replay = value;
+        } else {
+            return usage();
+        }
+    }
+
+    #ifdef _WIN32
+    // Headless runs only read files, which SDL does without being initialized.
+    SdlIo io;
+    #else
+    PosixIo io;
+    #endif
+    // Sized like the window's target at its default size and scale.
+    auto ring = shm_name ? std::optional<rt::SharedFrameRing>(std::in_place, io, *shm_name, 200, 150) : std::nullopt;
+
+    if (headless_frames) {
+        const auto stats = ring
+            ? rt::run_headless(instance, io, *ring, *headless_frames, log)
+            : rt::run_headless(instance, io, 200, 150, *headless_frames, log);
+        std::cout << "Frames: " << stats.frames << std::endl
+                  << "Init ms: " << stats.init_time << std::endl
+                  << "Total ms: " << stats.total_time << std::endl
+                  << "Update ms: " << stats.update_time << std::endl
+                  << "Draw ms: " << stats.draw_time << std::endl
+                  << "Frame ms (min/mean/max): "
+                  << stats.min_frame << " / " << stats.mean_frame << " / " << stats.max_frame << std::endl;
+        return 0;
+    }
+
+    if (ring) {
+        rt::run(instance, "RayTracer", 800, 600, 4, log, [&ring] (draw::Image const& frame) {
+            ring->submit(frame);
+        });
+    } else {
+        rt::run(instance, "RayTracer", 4, log);
+    }
 }
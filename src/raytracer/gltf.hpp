@@ -0,0 +1,770 @@
+// Binary glTF 2.0 (.glb) scene loading.
+//
+// Only the subset of the format the raytracer can actually represent is understood: triangle meshes with float
+// positions, node transforms and the metallic-roughness factors of materials. Textures, skins, animations and
+// cameras are ignored rather than rejected so that ordinary exported scenes still load.
+//
+// The JSON chunk is parsed into a small document model, but vertex and index data is never copied out of the
+// binary chunk ahead of time. Accessors are exposed as strided views into the file contents and decoded directly
+// into the final mesh storage, which is the only copy made.
+#pragma once
+#include <primitive>
+#include <math>
+#include <io>
+#include "world.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace raytracer::gltf {
+    /// An error raised while loading a glTF asset.
+    struct LoadError final {
+        /// The cause of the error.
+        enum class Reason {
+            NotBinaryGltf,
+            UnsupportedVersion,
+            MalformedContainer,
+            MalformedJson,
+            MissingBinaryChunk,
+            UnsupportedBuffer,
+            UnsupportedAccessor,
+            UnsupportedPrimitive,
+            OutOfBounds,
+        } reason;
+        /// A human readable description of what exactly was wrong.
+        std::optional<std::string> description { std::nullopt };
+    };
+
+    /// A mesh instance resolved from the scene graph together with the material it should be rendered with.
+    struct Instance final {
+        Mesh mesh;
+        BsdfMaterial::Config material;
+    };
+
+    /// Everything the raytracer understands out of a glTF scene.
+    struct Scene final {
+        std::vector<Instance> instances;
+    };
+}
+
+namespace raytracer::gltf::detail {
+    // The container is little endian and read with plain copies.
+    static_assert(std::endian::native == std::endian::little);
+
+    /// A minimal JSON document model, just enough to walk the glTF scene description.
+    ///
+    /// Objects store keys and values in parallel so lookup is linear, which is fine for the handful of
+    /// keys any glTF object actually has.
+    struct Json final {
+        enum class Kind { Null, Boolean, Number, String, Array, Object } kind { Kind::Null };
+        bool boolean { false };
+        f64 number { 0.0 };
+        std::string string;
+        /// Array elements or object values.
+        std::vector<Json> items;
+        /// Object keys, parallel to items.
+        std::vector<std::string> keys;
+
+        auto find(std::string_view key) const -> Json const* {
+            if (kind != Kind::Object) return nullptr;
+            for (usize i = 0; i < keys.size(); i += 1) if (keys[i] == key) return &items[i];
+            return nullptr;
+        }
+
+        auto at(usize index) const -> Json const* {
+            if (kind != Kind::Array or index >= items.size()) return nullptr;
+            return &items[index];
+        }
+
+        auto size() const -> usize {
+            return kind == Kind::Array ? items.size() : 0;
+        }
+
+        auto number_or(std::string_view key, f64 fallback) const -> f64 {
+            const auto value = find(key);
+            return value and value->kind == Kind::Number ? value->number : fallback;
+        }
+
+        auto index(std::string_view key) const -> std::optional<usize> {
+            const auto value = find(key);
+            // Anything past 2^32 can't index a real document and might not convert.
+            if (not value or value->kind != Kind::Number or not (value->number >= 0 and value->number < 0x1p32)) return std::nullopt;
+            if (value->number != std::floor(value->number)) return std::nullopt;
+            return usize(value->number);
+        }
+
+        /// Reads a fixed size array of numbers, keeping the fallback if it's absent or malformed.
+        template <const usize N> auto numbers_or(std::string_view key, std::array<f32, N> fallback) const -> std::array<f32, N> {
+            const auto value = find(key);
+            if (not value or value->kind != Kind::Array or value->items.size() != N) return fallback;
+            for (usize i = 0; i < N; i += 1) {
+                if (value->items[i].kind != Kind::Number) return fallback;
+                fallback[i] = f32(value->items[i].number);
+            }
+            return fallback;
+        }
+    };
+
+    class JsonParser final {
+        std::string_view src;
+        usize cursor { 0 };
+        u32 depth { 0 };
+
+        [[noreturn]] void fail(char const* what) const {
+            throw LoadError { LoadError::Reason::MalformedJson, std::string(what) + " at offset " + std::to_string(cursor) };
+        }
+
+        void skip_whitespace() {
+            while (cursor < src.size() and (src[cursor] == ' ' or src[cursor] == '\t' or src[cursor] == '\n' or src[cursor] == '\r'))
+                cursor += 1;
+        }
+
+        auto peek() const -> char {
+            return cursor < src.size() ? src[cursor] : '\0';
+        }
+
+        void expect(char c) {
+            if (peek() != c) fail("unexpected character");
+            cursor += 1;
+        }
+
+        void expect_literal(std::string_view literal) {
+            if (src.substr(cursor, literal.size()) != literal) fail("invalid literal");
+            cursor += literal.size();
+        }
+
+        static void push_utf8(std::string& out, u32 cp) {
+            if (cp < 0x80) {
+                out += char(cp);
+            } else if (cp < 0x800) {
+                out += char(0xC0 | (cp >> 6));
+                out += char(0x80 | (cp & 0x3F));
+            } else if (cp < 0x10000) {
+                out += char(0xE0 | (cp >> 12));
+                out += char(0x80 | ((cp >> 6) & 0x3F));
+                out += char(0x80 | (cp & 0x3F));
+            } else {
+                out += char(0xF0 | (cp >> 18));
+                out += char(0x80 | ((cp >> 12) & 0x3F));
+                out += char(0x80 | ((cp >> 6) & 0x3F));
+                out += char(0x80 | (cp & 0x3F));
+            }
+        }
+
+        auto parse_hex4() -> u32 {
+            if (cursor + 4 > src.size()) fail("truncated unicode escape");
+            u32 ret = 0;
+            for (usize i = 0; i < 4; i += 1) {
+                const char c = src[cursor++];
+                ret <<= 4;
+                if (c >= '0' and c <= '9') ret |= u32(c - '0');
+                else if (c >= 'a' and c <= 'f') ret |= u32(c - 'a' + 10);
+                else if (c >= 'A' and c <= 'F') ret |= u32(c - 'A' + 10);
+                else fail("invalid unicode escape");
+            }
+            return ret;
+        }
+
+        auto parse_string() -> std::string {
+            expect('"');
+            std::string ret;
+            while (true) {
+                if (cursor >= src.size()) fail("unterminated string");
+                const char c = src[cursor++];
+                if (c == '"') break;
+                if (c != '\\') { ret += c; continue; }
+
+                if (cursor >= src.size()) fail("unterminated escape");
+                switch (src[cursor++]) {
+                    case '"':  ret += '"';  break;
+                    case '\\': ret += '\\'; break;
+                    case '/':  ret += '/';  break;
+                    case 'b':  ret += '\b'; break;
+                    case 'f':  ret += '\f'; break;
+                    case 'n':  ret += '\n'; break;
+                    case 'r':  ret += '\r'; break;
+                    case 't':  ret += '\t'; break;
+                    case 'u': {
+                        u32 cp = parse_hex4();
+                        if (cp >= 0xD800 and cp < 0xDC00 and src.substr(cursor, 2) == "\\u") {
+                            cursor += 2;
+                            const u32 low = parse_hex4();
+                            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        push_utf8(ret, cp);
+                        break;
+                    }
+                    default: fail("invalid escape");
+                }
+            }
+            return ret;
+        }
+
+        auto parse_number() -> f64 {
+            const usize start = cursor;
+            while (cursor < src.size()) {
+                const char c = src[cursor];
+                if ((c >= '0' and c <= '9') or c == '-' or c == '+' or c == '.' or c == 'e' or c == 'E') cursor += 1;
+                else break;
+            }
+            const auto token = std::string(src.substr(start, cursor - start));
+            char* end = nullptr;
+            const f64 ret = std::strtod(token.c_str(), &end);
+            if (token.empty() or end != token.c_str() + token.size()) fail("invalid number");
+            return ret;
+        }
+
+        auto parse_value() -> Json {
+            // Scene descriptions are shallow, anything this deep is hostile input.
+            if (++depth > 256) fail("nesting too deep");
+
+            skip_whitespace();
+            Json ret;
+
+            switch (peek()) {
+                case '{':
+                    ret.kind = Json::Kind::Object;
+                    cursor += 1;
+                    skip_whitespace();
+                    if (peek() == '}') { cursor += 1; break; }
+                    while (true) {
+                        skip_whitespace();
+                        ret.keys.push_back(parse_string());
+                        skip_whitespace();
+                        expect(':');
+                        ret.items.push_back(parse_value());
+                        skip_whitespace();
+                        if (peek() == ',') { cursor += 1; continue; }
+                        expect('}');
+                        break;
+                    }
+                    break;
+                case '[':
+                    ret.kind = Json::Kind::Array;
+                    cursor += 1;
+                    skip_whitespace();
+                    if (peek() == ']') { cursor += 1; break; }
+                    while (true) {
+                        ret.items.push_back(parse_value());
+                        skip_whitespace();
+                        if (peek() == ',') { cursor += 1; continue; }
+                        expect(']');
+                        break;
+                    }
+                    break;
+                case '"':
+                    ret.kind = Json::Kind::String;
+                    ret.string = parse_string();
+                    break;
+                case 't':
+                    expect_literal("true");
+                    ret.kind = Json::Kind::Boolean;
+                    ret.boolean = true;
+                    break;
+                case 'f':
+                    expect_literal("false");
+                    ret.kind = Json::Kind::Boolean;
+                    break;
+                case 'n':
+                    expect_literal("null");
+                    break;
+                default:
+                    ret.kind = Json::Kind::Number;
+                    ret.number = parse_number();
+                    break;
+            }
+
+            depth -= 1;
+            return ret;
+        }
+
+      public:
+        explicit JsonParser(std::string_view src) : src(src) {}
+
+        auto parse() -> Json {
+            auto ret = parse_value();
+            skip_whitespace();
+            if (cursor != src.size()) fail("trailing characters");
+            return ret;
+        }
+    };
+
+    inline auto read_u32(std::span<const u8> data, usize offset) -> u32 {
+        if (offset + 4 > data.size()) throw LoadError { LoadError::Reason::MalformedContainer, "truncated header" };
+        u32 ret;
+        std::memcpy(&ret, data.data() + offset, sizeof(ret));
+        return ret;
+    }
+
+    /// A typed, strided view straight into the binary chunk.
+    ///
+    /// Elements are decoded on access and nothing is copied up front. Reads go through memcpy since
+    /// buffer views are only guaranteed to be aligned to their component size, not to anything we can
+    /// safely dereference as a wider type.
+    struct AccessorView final {
+        enum ComponentType : u32 {
+            Byte          = 5120,
+            UnsignedByte  = 5121,
+            Short         = 5122,
+            UnsignedShort = 5123,
+            UnsignedInt   = 5125,
+            Float         = 5126,
+        };
+
+        u8 const* base { nullptr };
+        usize count { 0 };
+        usize stride { 0 };
+        ComponentType component_type { Float };
+        u32 components { 1 };
+
+        static constexpr auto component_size(ComponentType type) -> usize {
+            switch (type) {
+                case Byte:
+                case UnsignedByte:  return 1;
+                case Short:
+                case UnsignedShort: return 2;
+                case UnsignedInt:
+                case Float:         return 4;
+            }
+            return 0;
+        }
+
+        auto f32_at(usize element, u32 component) const -> f32 {
+            f32 ret;
+            std::memcpy(&ret, base + element * stride + component * sizeof(f32), sizeof(ret));
+            return ret;
+        }
+
+        auto index_at(usize element) const -> u32 {
+            u8 const* at = base + element * stride;
+            switch (component_type) {
+                case UnsignedByte: return *at;
+                case UnsignedShort: { u16 ret; std::memcpy(&ret, at, sizeof(ret)); return ret; }
+                case UnsignedInt:   { u32 ret; std::memcpy(&ret, at, sizeof(ret)); return ret; }
+                default: std::unreachable();
+            }
+        }
+    };
+
+    inline auto component_count(std::string_view type) -> u32 {
+        if (type == "SCALAR") return 1;
+        if (type == "VEC2") return 2;
+        if (type == "VEC3") return 3;
+        if (type == "VEC4") return 4;
+        if (type == "MAT2") return 4;
+        if (type == "MAT3") return 9;
+        if (type == "MAT4") return 16;
+        return 0;
+    }
+
+    /// Reads an optional non-negative integer of at most `limit`, throwing rather than converting numbers
+    /// which are fractional, negative or too large, whose conversion would be undefined.
+    inline auto bounded(Json const& object, std::string_view key, usize limit) -> usize {
+        const f64 value = object.number_or(key, 0);
+        if (not (value >= 0 and value <= f64(limit)) or value != std::floor(value))
+            throw LoadError { LoadError::Reason::OutOfBounds, std::string(key) + " " + std::to_string(value) };
+        return usize(value);
+    }
+
+    /// Resolves an accessor into a view over the binary chunk, validating every byte it could touch.
+    inline auto view(Json const& doc, std::span<const u8> bin, usize accessor_index) -> AccessorView {
+        using enum LoadError::Reason;
+
+        const auto accessors = doc.find("accessors");
+        const auto accessor = accessors ? accessors->at(accessor_index) : nullptr;
+        if (not accessor) throw LoadError { OutOfBounds, "accessor index " + std::to_string(accessor_index) };
+
+        if (accessor->find("sparse")) throw LoadError { UnsupportedAccessor, "sparse accessors" };
+
+        const auto view_index = accessor->index("bufferView");
+        if (not view_index) throw LoadError { UnsupportedAccessor, "accessor without a buffer view" };
+
+        const auto views = doc.find("bufferViews");
+        const auto buffer_view = views ? views->at(*view_index) : nullptr;
+        if (not buffer_view) throw LoadError { OutOfBounds, "buffer view index " + std::to_string(*view_index) };
+
+        const auto buffer_index = buffer_view->index("buffer").value_or(0);
+        const auto buffers = doc.find("buffers");
+        const auto buffer = buffers ? buffers->at(buffer_index) : nullptr;
+        if (not buffer) throw LoadError { OutOfBounds, "buffer index " + std::to_string(buffer_index) };
+        // In a .glb only the first buffer may omit its uri, that one is the binary chunk.
+        if (buffer_index != 0 or buffer->find("uri")) throw LoadError { UnsupportedBuffer, "external or embedded uri buffers" };
+
+        AccessorView ret;
+        ret.component_type = AccessorView::ComponentType(u32(bounded(*accessor, "componentType", 0xFFFF)));
+        // Every element takes at least a byte, larger values can't possibly fit.
+        ret.count = bounded(*accessor, "count", bin.size());
+
+        const auto type = accessor->find("type");
+        ret.components = type and type->kind == Json::Kind::String ? component_count(type->string) : 0;
+
+        const usize component_size = AccessorView::component_size(ret.component_type);
+        if (component_size == 0 or ret.components == 0) throw LoadError { UnsupportedAccessor, "unknown component layout" };
+
+        const usize element_size = component_size * ret.components;
+        const usize view_offset = bounded(*buffer_view, "byteOffset", bin.size());
+        const usize view_length = bounded(*buffer_view, "byteLength", bin.size());
+        const usize accessor_offset = bounded(*accessor, "byteOffset", bin.size());
+        ret.stride = bounded(*buffer_view, "byteStride", bin.size());
+        if (ret.stride == 0) ret.stride = element_size;
+
+        // Written as differences and a quotient so none of it can wrap around.
+        if (view_length > bin.size() - view_offset)
+            throw LoadError { OutOfBounds, "buffer view exceeds the binary chunk" };
+        if (ret.count > 0 and (
+            accessor_offset > view_length
+            or element_size > view_length - accessor_offset
+            or ret.count - 1 > (view_length - accessor_offset - element_size) / ret.stride
+        )) throw LoadError { OutOfBounds, "accessor exceeds its buffer view" };
+
+        ret.base = bin.data() + view_offset + accessor_offset;
+        return ret;
+    }
+
+    struct Quaternion final {
+        f32 x { 0.f }, y { 0.f }, z { 0.f }, w { 1.f };
+
+        auto operator*(Quaternion const& rhs) const -> Quaternion {
+            return {
+                w * rhs.x + x * rhs.w + y * rhs.z - z * rhs.y,
+                w * rhs.y - x * rhs.z + y * rhs.w + z * rhs.x,
+                w * rhs.z + x * rhs.y - y * rhs.x + z * rhs.w,
+                w * rhs.w - x * rhs.x - y * rhs.y - z * rhs.z,
+            };
+        }
+
+        /// The equivalent column-vector rotation matrix, indexed as [row][column].
+        auto matrix() const -> std::array<std::array<f32, 3>, 3> {
+            return {{
+                { 1.f - 2.f * (y * y + z * z), 2.f * (x * y - z * w),       2.f * (x * z + y * w)       },
+                { 2.f * (x * y + z * w),       1.f - 2.f * (x * x + z * z), 2.f * (y * z - x * w)       },
+                { 2.f * (x * z - y * w),       2.f * (y * z + x * w),       1.f - 2.f * (x * x + y * y) },
+            }};
+        }
+
+        auto rotate(std::array<f32, 3> v) const -> std::array<f32, 3> {
+            const auto m = matrix();
+            return {
+                m[0][0] * v[0] + m[0][1] * v[1] + m[0][2] * v[2],
+                m[1][0] * v[0] + m[1][1] * v[1] + m[1][2] * v[2],
+                m[2][0] * v[0] + m[2][1] * v[1] + m[2][2] * v[2],
+            };
+        }
+
+        static auto from_matrix(std::array<std::array<f32, 3>, 3> const& m) -> Quaternion {
+            const f32 trace = m[0][0] + m[1][1] + m[2][2];
+            if (trace > 0.f) {
+                const f32 s = std::sqrt(trace + 1.f) * 2.f;
+                return { (m[2][1] - m[1][2]) / s, (m[0][2] - m[2][0]) / s, (m[1][0] - m[0][1]) / s, .25f * s };
+            } else if (m[0][0] > m[1][1] and m[0][0] > m[2][2]) {
+                const f32 s = std::sqrt(1.f + m[0][0] - m[1][1] - m[2][2]) * 2.f;
+                return { .25f * s, (m[0][1] + m[1][0]) / s, (m[0][2] + m[2][0]) / s, (m[2][1] - m[1][2]) / s };
+            } else if (m[1][1] > m[2][2]) {
+                const f32 s = std::sqrt(1.f + m[1][1] - m[0][0] - m[2][2]) * 2.f;
+                return { (m[0][1] + m[1][0]) / s, .25f * s, (m[1][2] + m[2][1]) / s, (m[0][2] - m[2][0]) / s };
+            } else {
+                const f32 s = std::sqrt(1.f + m[2][2] - m[0][0] - m[1][1]) * 2.f;
+                return { (m[0][2] + m[2][0]) / s, (m[1][2] + m[2][1]) / s, .25f * s, (m[1][0] - m[0][1]) / s };
+            }
+        }
+    };
+
+    /// A decomposed node transform. Hierarchies are composed in this form, which is exact for uniform scale
+    /// and an approximation (shear is dropped) for non-uniform scale under rotation.
+    struct Transform final {
+        std::array<f32, 3> translation { 0.f, 0.f, 0.f };
+        Quaternion rotation;
+        std::array<f32, 3> scale { 1.f, 1.f, 1.f };
+
+        auto operator*(Transform const& child) const -> Transform {
+            const auto scaled = std::array<f32, 3> {
+                child.translation[0] * scale[0], child.translation[1] * scale[1], child.translation[2] * scale[2]
+            };
+            const auto rotated = rotation.rotate(scaled);
+            return {
+                { translation[0] + rotated[0], translation[1] + rotated[1], translation[2] + rotated[2] },
+                rotation * child.rotation,
+                { scale[0] * child.scale[0], scale[1] * child.scale[1], scale[2] * child.scale[2] },
+            };
+        }
+
+        static auto of(Json const& node) -> Transform {
+            Transform ret;
+
+            if (const auto m = node.find("matrix"); m and m->kind == Json::Kind::Array and m->items.size() == 16) {
+                // Column-major, so element (row, column) lives at column * 4 + row.
+                const auto e = [m] (usize row, usize column) { return f32(m->items[column * 4 + row].number); };
+
+                ret.translation = { e(0, 3), e(1, 3), e(2, 3) };
+                for (usize c = 0; c < 3; c += 1)
+                    ret.scale[c] = std::sqrt(e(0, c) * e(0, c) + e(1, c) * e(1, c) + e(2, c) * e(2, c));
+
+                std::array<std::array<f32, 3>, 3> rotation;
+                for (usize r = 0; r < 3; r += 1)
+                    for (usize c = 0; c < 3; c += 1)
+                        rotation[r][c] = ret.scale[c] != 0.f ? e(r, c) / ret.scale[c] : 0.f;
+                ret.rotation = Quaternion::from_matrix(rotation);
+                return ret;
+            }
+
+            ret.translation = node.numbers_or<3>("translation", ret.translation);
+            ret.scale = node.numbers_or<3>("scale", ret.scale);
+            const auto q = node.numbers_or<4>("rotation", { 0.f, 0.f, 0.f, 1.f });
+            ret.rotation = { q[0], q[1], q[2], q[3] };
+            return ret;
+        }
+    };
+
+    inline auto material_config(Json const& doc, std::optional<usize> index) -> BsdfMaterial::Config {
+        // The glTF default material is a fully rough white metal.
+        BsdfMaterial::Config ret { .color = { 1.f, 1.f, 1.f }, .roughness = 1.f, .metallic = 1.f };
+
+        const auto materials = doc.find("materials");
+        const auto material = materials and index ? materials->at(*index) : nullptr;
+        if (not material) return ret;
+
+        if (const auto pbr = material->find("pbrMetallicRoughness")) {
+            const auto color = pbr->numbers_or<4>("baseColorFactor", { 1.f, 1.f, 1.f, 1.f });
+            ret.color = { color[0], color[1], color[2] };
+            ret.metallic = f32(pbr->number_or("metallicFactor", 1.0));
+            ret.roughness = f32(pbr->number_or("roughnessFactor", 1.0));
+        }
+
+        auto emissive = material->numbers_or<3>("emissiveFactor", { 0.f, 0.f, 0.f });
+        if (const auto extensions = material->find("extensions")) {
+            if (const auto strength = extensions->find("KHR_materials_emissive_strength")) {
+                const f32 factor = f32(strength->number_or("emissiveStrength", 1.0));
+                for (auto& e : emissive) e *= factor;
+            }
+        }
+        ret.emissive = { emissive[0], emissive[1], emissive[2] };
+
+        return ret;
+    }
+
+    /// Converts one primitive into a mesh placed with the given world transform.
+    ///
+    /// glTF is right-handed while the raytracer looks down +Z, so geometry is mirrored on Z and the
+    /// winding flipped to keep face normals pointing outward.
+    inline auto primitive_mesh(Json const& doc, std::span<const u8> bin, Json const& primitive, Transform const& transform) -> Mesh {
+        using enum LoadError::Reason;
+
+        const auto mode = usize(primitive.number_or("mode", 4));
+        if (mode != 4 and mode != 5 and mode != 6)
+            throw LoadError { UnsupportedPrimitive, "primitive mode " + std::to_string(mode) };
+
+        const auto attributes = primitive.find("attributes");
+        const auto position_index = attributes ? attributes->index("POSITION") : std::nullopt;
+        if (not position_index) throw LoadError { UnsupportedPrimitive, "primitive without positions" };
+
+        const auto positions = view(doc, bin, *position_index);
+        if (positions.component_type != AccessorView::Float or positions.components != 3)
+            throw LoadError { UnsupportedAccessor, "positions must be float VEC3" };
+
+        // Non-uniform scale can't be expressed by the mesh transform so it is baked into the vertices instead.
+        const auto& s = transform.scale;
+        const bool uniform = std::abs(s[0] - s[1]) < 1e-6f and std::abs(s[0] - s[2]) < 1e-6f;
+        const std::array<f32, 3> bake = uniform ? std::array { 1.f, 1.f, 1.f } : s;
+
+        Mesh::Geometry geometry;
+        geometry.vertices.reserve(positions.count);
+        for (usize i = 0; i < positions.count; i += 1) {
+            geometry.vertices.emplace_back(
+                 positions.f32_at(i, 0) * bake[0],
+                 positions.f32_at(i, 1) * bake[1],
+                -positions.f32_at(i, 2) * bake[2]
+            );
+        }
+
+        std::optional<AccessorView> indices;
+        if (const auto index = primitive.index("indices")) {
+            indices = view(doc, bin, *index);
+            const auto type = indices->component_type;
+            if (indices->components != 1 or (type != AccessorView::UnsignedByte and type != AccessorView::UnsignedShort and type != AccessorView::UnsignedInt))
+                throw LoadError { UnsupportedAccessor, "indices must be unsigned scalars" };
+        }
+
+        const usize index_count = indices ? indices->count : positions.count;
+        const auto index_at = [&] (usize i) -> usize {
+            const usize ret = indices ? indices->index_at(i) : i;
+            if (ret >= positions.count) throw LoadError { OutOfBounds, "vertex index " + std::to_string(ret) };
+            return ret;
+        };
+
+        switch (mode) {
+            case 4:
+                geometry.faces.reserve(index_count / 3);
+                for (usize i = 0; i + 2 < index_count; i += 3)
+                    geometry.faces.push_back({ index_at(i), index_at(i + 2), index_at(i + 1) });
+                break;
+            case 5:
+                geometry.faces.reserve(index_count > 2 ? index_count - 2 : 0);
+                for (usize i = 0; i + 2 < index_count; i += 1) {
+                    if (i % 2 == 0) geometry.faces.push_back({ index_at(i), index_at(i + 2), index_at(i + 1) });
+                    else            geometry.faces.push_back({ index_at(i), index_at(i + 1), index_at(i + 2) });
+                }
+                break;
+            case 6:
+                geometry.faces.reserve(index_count > 2 ? index_count - 2 : 0);
+                for (usize i = 1; i + 1 < index_count; i += 1)
+                    geometry.faces.push_back({ index_at(0), index_at(i + 1), index_at(i) });
+                break;
+        }
+
+        // Mirror the transform on Z to match the mirrored geometry.
+        const auto q = Quaternion { -transform.rotation.x, -transform.rotation.y, transform.rotation.z, transform.rotation.w };
+        const auto m = q.matrix();
+
+        // The mesh applies pitch, yaw and roll as row-vector matrices, which as a column-vector rotation is
+        // Rz(-roll) * Ry(-yaw) * Rx(-pitch). Decompose accordingly, handling gimbal lock when yaw is ±90°.
+        f32 alpha, beta, gamma;
+        if (std::abs(m[2][0]) < .99999f) {
+            beta = std::asin(-m[2][0]);
+            alpha = std::atan2(m[2][1], m[2][2]);
+            gamma = std::atan2(m[1][0], m[0][0]);
+        } else {
+            beta = m[2][0] < 0.f ? f32(math::pi) / 2.f : -f32(math::pi) / 2.f;
+            alpha = std::atan2(-m[1][2], m[1][1]);
+            gamma = 0.f;
+        }
+
+        geometry.compute_bvh();
+
+        Mesh mesh;
+        mesh.geometry = std::make_shared<const Mesh::Geometry>(std::move(geometry));
+        mesh.position = { transform.translation[0], transform.translation[1], -transform.translation[2] };
+        mesh.scale = uniform ? s[0] : 1.f;
+        mesh.pitch = math::rad(-alpha);
+        mesh.yaw = math::rad(-beta);
+        mesh.roll = math::rad(-gamma);
+
+        return mesh;
+    }
+
+    inline void visit_node(Json const& doc, std::span<const u8> bin, usize node_index, Transform const& parent, Scene& scene, u32 depth) {
+        if (depth > 64) throw LoadError { LoadError::Reason::MalformedJson, "node hierarchy too deep or cyclic" };
+
+        const auto nodes = doc.find("nodes");
+        const auto node = nodes ? nodes->at(node_index) : nullptr;
+        if (not node) throw LoadError { LoadError::Reason::OutOfBounds, "node index " + std::to_string(node_index) };
+
+        const auto transform = parent * Transform::of(*node);
+
+        if (const auto mesh_index = node->index("mesh")) {
+            const auto meshes = doc.find("meshes");
+            const auto mesh = meshes ? meshes->at(*mesh_index) : nullptr;
+            if (not mesh) throw LoadError { LoadError::Reason::OutOfBounds, "mesh index " + std::to_string(*mesh_index) };
+
+            if (const auto primitives = mesh->find("primitives")) {
+                for (auto const& primitive : primitives->items) {
+                    scene.instances.push_back(Instance {
+                        primitive_mesh(doc, bin, primitive, transform),
+                        material_config(doc, primitive.index("material")),
+                    });
+                }
+            }
+        }
+
+        if (const auto children = node->find("children")) {
+            for (auto const& child : children->items) {
+                if (child.kind != Json::Kind::Number) continue;
+                visit_node(doc, bin, usize(child.number), transform, scene, depth + 1);
+            }
+        }
+    }
+}
+
+namespace raytracer::gltf {
+    /// Parses the contents of a binary glTF file.
+    ///
+    /// This is pure, all vertex data is decoded straight out of the provided bytes into the resulting meshes.
+    inline auto parse_glb(std::span<const u8> data) -> Scene {
+        using enum LoadError::Reason;
+        using detail::read_u32;
+
+        constexpr u32 MAGIC      = 0x46546C67; // "glTF"
+        constexpr u32 CHUNK_JSON = 0x4E4F534A; // "JSON"
+        constexpr u32 CHUNK_BIN  = 0x004E4942; // "BIN\0"
+
+        if (data.size() < 12 or read_u32(data, 0) != MAGIC) throw LoadError { NotBinaryGltf };
+        if (const auto version = read_u32(data, 4); version != 2)
+            throw LoadError { UnsupportedVersion, "version " + std::to_string(version) };
+
+        const usize length = std::min<usize>(read_u32(data, 8), data.size());
+
+        std::optional<std::string_view> json;
+        std::span<const u8> bin;
+
+        for (usize offset = 12; offset + 8 <= length;) {
+            const usize chunk_length = read_u32(data, offset);
+            const u32 chunk_type = read_u32(data, offset + 4);
+            if (offset + 8 + chunk_length > length) throw LoadError { MalformedContainer, "chunk exceeds file length" };
+
+            const auto chunk = data.subspan(offset + 8, chunk_length);
+            if (chunk_type == CHUNK_JSON and not json) json = std::string_view((char const*) chunk.data(), chunk.size());
+            else if (chunk_type == CHUNK_BIN and bin.empty()) bin = chunk;
+
+            // Chunks are padded to 4 bytes.
+            offset += 8 + ((chunk_length + 3) & ~usize(3));
+        }
+
+        if (not json) throw LoadError { MalformedContainer, "missing JSON chunk" };
+
+        const auto doc = detail::JsonParser(*json).parse();
+        if (doc.find("buffers") and bin.empty()) throw LoadError { MissingBinaryChunk };
+
+        Scene scene;
+        const auto root = detail::Transform {};
+
+        const auto scenes = doc.find("scenes");
+        const auto default_scene = scenes ? scenes->at(doc.index("scene").value_or(0)) : nullptr;
+
+        if (default_scene) {
+            if (const auto roots = default_scene->find("nodes")) {
+                for (auto const& node : roots->items) {
+                    if (node.kind != detail::Json::Kind::Number) continue;
+                    detail::visit_node(doc, bin, usize(node.number), root, scene, 0);
+                }
+            }
+        } else if (const auto nodes = doc.find("nodes")) {
+            // Without a scene every node which isn't somebody's child is a root.
+            std::vector<bool> is_child(nodes->size(), false);
+            for (auto const& node : nodes->items) {
+                if (const auto children = node.find("children")) {
+                    for (auto const& child : children->items) {
+                        if (child.kind == detail::Json::Kind::Number and usize(child.number) < is_child.size())
+                            is_child[usize(child.number)] = true;
+                    }
+                }
+            }
+            for (usize i = 0; i < nodes->size(); i += 1)
+                if (not is_child[i]) detail::visit_node(doc, bin, i, root, scene, 0);
+        }
+
+        return scene;
+    }
+
+    /// Loads the default scene of a binary glTF file into the world.
+    ///
+    /// Returns references to the added meshes in scene graph order so they can be animated afterwards.
+    inline auto load_glb(Io& io, World& world, std::string_view path) -> std::vector<World::Ref<Mesh>> {
+        const auto data = io.read_file(path);
+        auto scene = parse_glb(data);
+
+        std::vector<World::Ref<Mesh>> ret;
+        ret.reserve(scene.instances.size());
+        for (auto& instance : scene.instances) {
+            ret.push_back(world.add(std::move(instance.mesh), BsdfMaterial(instance.material)));
+        }
+        return ret;
+    }
+}
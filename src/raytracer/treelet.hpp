@@ -0,0 +1,315 @@
+// Out-of-core mesh storage.
+//
+// A mesh BVH is cut into treelets, self-contained subtrees carrying their own vertices and faces, and written to
+// a file alongside the small top-level tree that references them. At render time only the top-level tree is
+// resident, treelets are paged in from the file on demand by traversal and evicted in least recently used order
+// once the resident set exceeds a byte budget.
+//
+// The file layout is:
+//
+// - Header
+// - Node[header.top_node_count], the top-level tree, root first
+// - Entry[header.treelet_count], the treelet directory
+// - Treelet blobs at the offsets recorded in the directory, each one being
+//     Node[entry.node_count], f32[entry.vertex_count][3], u32[entry.face_count][3]
+//
+// Everything is little endian and written with plain copies of the structures below.
+#pragma once
+#include <primitive>
+#include <math>
+#include <io>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace raytracer::treelet {
+    static_assert(std::endian::native == std::endian::little);
+
+    constexpr u32 MAGIC = 0x544C5452; // "RTLT"
+    constexpr u32 VERSION = 1;
+
+    /// An error raised while opening a treelet file.
+    struct FormatError final {
+        enum class Reason {
+            NotATreeletFile,
+            UnsupportedVersion,
+            Truncated,
+            /// An index out of range, a cycle or a tree deeper than MAX_DEPTH.
+            Corrupt,
+        } reason;
+        std::optional<std::string> description { std::nullopt };
+    };
+
+    /// A flattened BVH node shared by the top-level tree and treelets.
+    struct Node final {
+        enum Kind : u32 {
+            /// `first` and `second` are the indices of the children.
+            Interior,
+            /// `first` is the first face and `second` the face count.
+            Leaf,
+            /// Only in the top-level tree, `first` is the index of the treelet to descend into.
+            Link,
+        };
+
+        std::array<f32, 3> bound_min;
+        std::array<f32, 3> bound_max;
+        u32 first;
+        u32 second;
+        Kind kind;
+        u32 padding { 0 };
+    };
+
+    struct Header final {
+        u32 magic;
+        u32 version;
+        u32 top_node_count;
+        u32 treelet_count;
+    };
+
+    struct Entry final {
+        u64 offset;
+        u32 node_count;
+        u32 vertex_count;
+        u32 face_count;
+        u32 padding { 0 };
+
+        constexpr auto byte_size() const -> usize {
+            return usize(node_count) * sizeof(Node)
+                 + usize(vertex_count) * sizeof(f32) * 3
+                 + usize(face_count) * sizeof(u32) * 3;
+        }
+    };
+
+    /// The most nodes on a path from a root to a leaf, in the top-level tree and in treelets alike.
+    /// Traversal keeps pending nodes on a fixed stack, which never holds more than this many.
+    constexpr u32 MAX_DEPTH = 64;
+
+    /// The most nodes on a path from the root to a leaf, with children expected after their parents
+    /// as they are in files. Nodes which aren't reachable from the root don't count.
+    inline auto depth_of(std::span<const Node> nodes) -> u32 {
+        std::vector<u32> depths(nodes.size(), 0);
+        u32 ret = 0;
+        if (not nodes.empty()) depths[0] = 1;
+        for (usize i = 0; i < nodes.size(); i += 1) {
+            if (depths[i] == 0) continue;
+            ret = std::max(ret, depths[i]);
+            if (nodes[i].kind == Node::Interior) {
+                for (const u32 child : { nodes[i].first, nodes[i].second }) depths[child] = std::max(depths[child], depths[i] + 1);
+            }
+        }
+        return ret;
+    }
+
+    /// Checks a tree read from a file before anything traverses it, throwing FormatError unless every
+    /// child comes after its parent and is in range, terminal nodes are of the expected kind and
+    /// refer to fewer than `limit` treelets or at most `limit` faces, and the tree isn't too deep.
+    inline void validate(std::span<const Node> nodes, Node::Kind terminal, u64 limit) {
+        for (usize i = 0; i < nodes.size(); i += 1) {
+            Node const& node = nodes[i];
+            bool valid;
+            switch (node.kind) {
+                case Node::Interior:
+                    valid = node.first > i and node.first < nodes.size() and node.second > i and node.second < nodes.size();
+                    break;
+                case Node::Leaf:
+                    valid = terminal == Node::Leaf and u64(node.first) + node.second <= limit;
+                    break;
+                case Node::Link:
+                    valid = terminal == Node::Link and node.first < limit;
+                    break;
+                default:
+                    valid = false;
+            }
+            if (not valid) throw FormatError { FormatError::Reason::Corrupt, "node " + std::to_string(i) };
+        }
+        if (depth_of(nodes) > MAX_DEPTH) throw FormatError { FormatError::Reason::Corrupt, "tree too deep" };
+    }
+
+    static_assert(std::is_trivially_copyable_v<Node> and sizeof(Node) == 40);
+    static_assert(std::is_trivially_copyable_v<Header> and sizeof(Header) == 16);
+    static_assert(std::is_trivially_copyable_v<Entry> and sizeof(Entry) == 24);
+
+    /// A resident treelet.
+    struct Treelet final {
+        std::vector<Node> nodes;
+        std::vector<math::Vector<f32, 3>> vertices;
+        std::vector<std::array<u32, 3>> faces;
+
+        /// Decodes a treelet blob, throwing FormatError if it's short or refers to anything it doesn't have.
+        static auto decode(Entry const& entry, std::span<const u8> blob) -> Treelet {
+            if (blob.size() < entry.byte_size()) throw FormatError { FormatError::Reason::Truncated, "treelet" };
+            Treelet ret;
+            ret.nodes.resize(entry.node_count);
+            ret.vertices.reserve(entry.vertex_count);
+            ret.faces.resize(entry.face_count);
+
+            usize cursor = 0;
+            std::memcpy(ret.nodes.data(), blob.data() + cursor, entry.node_count * sizeof(Node));
+            cursor += entry.node_count * sizeof(Node);
+
+            for (u32 i = 0; i < entry.vertex_count; i += 1) {
+                f32 v[3];
+                std::memcpy(v, blob.data() + cursor, sizeof(v));
+                cursor += sizeof(v);
+                ret.vertices.emplace_back(v[0], v[1], v[2]);
+            }
+
+            std::memcpy(ret.faces.data(), blob.data() + cursor, entry.face_count * sizeof(std::array<u32, 3>));
+
+            validate(ret.nodes, Node::Leaf, entry.face_count);
+            for (auto const& face : ret.faces) {
+                for (const u32 vertex : face) {
+                    if (vertex >= entry.vertex_count) throw FormatError { FormatError::Reason::Corrupt, "vertex index" };
+                }
+            }
+            return ret;
+        }
+    };
+
+    /// Appends the raw bytes of trivially copyable values to a buffer.
+    template <typename T> void append(std::vector<u8>& out, std::span<const T> values) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const auto bytes = std::as_bytes(values);
+        out.insert(out.end(), (u8 const*) bytes.data(), (u8 const*) bytes.data() + bytes.size());
+    }
+
+    template <typename T> void append(std::vector<u8>& out, T const& value) {
+        append(out, std::span<const T>(&value, 1));
+    }
+
+    /// The residency manager of an opened treelet file.
+    ///
+    /// Treelets are handed out as shared pointers so one evicted while a ray is still traversing it stays
+    /// alive until that traversal is done, the budget is therefore a target and not a hard limit.
+    /// All operations are thread-safe, the file is read outside of the lock so misses on different
+    /// treelets can be serviced concurrently.
+    class Cache final {
+        Io::File file;
+        std::vector<Node> top;
+        std::vector<Entry> directory;
+        usize budget;
+
+        struct Resident final {
+            std::shared_ptr<const Treelet> treelet;
+            std::list<u32>::iterator position;
+        };
+
+        std::mutex lock;
+        /// Most recently used at the front.
+        std::list<u32> recency;
+        std::unordered_map<u32, Resident> resident;
+        usize resident_bytes { 0 };
+
+      public:
+        struct Stats final {
+            usize hits { 0 };
+            usize misses { 0 };
+            usize evictions { 0 };
+            usize resident_bytes { 0 };
+            usize resident_treelets { 0 };
+        };
+
+      private:
+        Stats counters;
+
+        void evict_locked(u32 keep) {
+            while (resident_bytes > budget and not recency.empty()) {
+                const u32 victim = recency.back();
+                if (victim == keep) break;
+                recency.pop_back();
+                resident_bytes -= directory[victim].byte_size();
+                resident.erase(victim);
+                counters.evictions += 1;
+            }
+        }
+
+      public:
+        Cache(Io::File file, usize budget) : file(std::move(file)), budget(budget) {
+            Header header;
+            this->file.read(0, std::span((u8*) &header, sizeof(header)));
+            if (header.magic != MAGIC) throw FormatError { FormatError::Reason::NotATreeletFile };
+            if (header.version != VERSION)
+                throw FormatError { FormatError::Reason::UnsupportedVersion, "version " + std::to_string(header.version) };
+            if (header.top_node_count == 0) throw FormatError { FormatError::Reason::Truncated, "empty top-level tree" };
+
+            const u64 size = this->file.size();
+            const u64 tables = sizeof(Header) + u64(header.top_node_count) * sizeof(Node) + u64(header.treelet_count) * sizeof(Entry);
+            if (tables > size) throw FormatError { FormatError::Reason::Truncated, "top-level tree" };
+
+            top.resize(header.top_node_count);
+            directory.resize(header.treelet_count);
+
+            u64 cursor = sizeof(Header);
+            this->file.read(cursor, std::span((u8*) top.data(), top.size() * sizeof(Node)));
+            cursor += top.size() * sizeof(Node);
+            this->file.read(cursor, std::span((u8*) directory.data(), directory.size() * sizeof(Entry)));
+
+            for (auto const& entry : directory) {
+                if (entry.offset > size or entry.byte_size() > size - entry.offset) throw FormatError { FormatError::Reason::Truncated };
+            }
+            validate(top, Node::Link, directory.size());
+        }
+
+        /// The resident top-level tree, its root is the first node.
+        auto top_level() const -> std::span<const Node> {
+            return top;
+        }
+
+        /// Returns the treelet, paging it in if it isn't resident.
+        auto acquire(u32 index) -> std::shared_ptr<const Treelet> {
+            {
+                std::lock_guard guard { lock };
+                if (auto it = resident.find(index); it != resident.end()) {
+                    recency.splice(recency.begin(), recency, it->second.position);
+                    counters.hits += 1;
+                    return it->second.treelet;
+                }
+                counters.misses += 1;
+            }
+
+            auto const& entry = directory.at(index);
+            std::vector<u8> blob(entry.byte_size());
+            file.read(entry.offset, blob);
+            auto loaded = std::make_shared<const Treelet>(Treelet::decode(entry, blob));
+
+            std::lock_guard guard { lock };
+            // Another thread could have paged the same treelet in while we were reading.
+            if (auto it = resident.find(index); it != resident.end()) {
+                recency.splice(recency.begin(), recency, it->second.position);
+                return it->second.treelet;
+            }
+
+            recency.push_front(index);
+            resident.emplace(index, Resident { loaded, recency.begin() });
+            resident_bytes += entry.byte_size();
+            evict_locked(index);
+
+            return loaded;
+        }
+
+        /// Changes the residency budget, evicting immediately if it shrank.
+        void set_budget(usize bytes) {
+            std::lock_guard guard { lock };
+            budget = bytes;
+            evict_locked(recency.empty() ? u32(-1) : recency.front());
+        }
+
+        auto stats() -> Stats {
+            std::lock_guard guard { lock };
+            auto ret = counters;
+            ret.resident_bytes = resident_bytes;
+            ret.resident_treelets = resident.size();
+            return ret;
+        }
+    };
+}
@@ -10,7 +10,7 @@ auto LambertMaterial::shade(Hit hit, World const& world, u32 depth) const -> ray
     for (const auto light : world.lights()) {
         const auto light_direction = (light.position - hit.origin).normalized();
         const auto distance_to_light = (light.position - hit.origin).magnitude();
-        const auto view_direction = (world.get_camera_position() - hit.origin).normalized();
+        const auto view_direction = (hit.eye - hit.origin).normalized();
         const auto half = (view_direction + light_direction).normalized();
 
         if (world.get_shadows()) [[likely]] {
@@ -39,7 +39,7 @@ auto BsdfMaterial::shade(Hit hit, World const& world, u32 depth) const -> raytra
     Vector out_color;
 
     const auto base_reflectivity = math::mix(Vector(.04f), base_color, metallic);
-    const auto view_direction = (world.get_camera_position() - hit.origin).normalized();
+    const auto view_direction = (hit.eye - hit.origin).normalized();
 
     // Specular and diffuse pass ---------------------------------------------------------------------------------------
     for (const auto light : world.lights()) {
@@ -112,6 +112,7 @@ auto BsdfMaterial::shade(Hit hit, World const& world, u32 depth) const -> raytra
         const auto reflect_origin = hit.origin + hit.normal * EPSILON;
 
         if (auto next_hit = world.cast_ray(reflect_origin, reflect_direction)) {
+            next_hit->eye = hit.eye;
             auto reflected_color = world.material(next_hit->material_index).shade(*next_hit, world, depth + 1);
 
             const auto reflection_strength = (1.f - roughness);
@@ -127,7 +128,7 @@ auto BsdfMaterial::shade(Hit hit, World const& world, u32 depth) const -> raytra
         } else {
             const auto specular = Vector(world.get_background_color()).hadamard(
                 base_reflectivity + (Vector(1.f) - base_reflectivity) * std::pow(
-                    1.f - std::clamp(hit.normal.dot((world.get_camera_position() - hit.origin).normalized()), 0.f, 1.f),
+                    1.f - std::clamp(hit.normal.dot((hit.eye - hit.origin).normalized()), 0.f, 1.f),
                     5.f
                 )
             ).hadamard(math::mix(Vector(1.f), base_color, metallic));
@@ -212,6 +213,7 @@ auto BsdfMaterial::shade(Hit hit, World const& world, u32 depth) const -> raytra
                 const auto world_dir = tangent * dir.x() + hit.normal * dir.y() + bitangent * dir.z();
 
                 if (auto bounce_hit = world.cast_ray(gi_origin, world_dir)) {
+                    bounce_hit->eye = hit.eye;
                     const auto bounce_color = world.material(bounce_hit->material_index).shade(*bounce_hit, world, depth + 1);
 
                     const f32 cosine = std::max(0.f, world_dir.dot(hit.normal));
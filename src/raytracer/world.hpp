@@ -9,8 +9,16 @@
 #include <concepts>
 #include <vector>
 #include <span>
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <thread>
 #include <ranges>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include "treelet.hpp"
 
 namespace raytracer {
     /// A simple floating point color type.
@@ -62,6 +70,8 @@ namespace raytracer {
 		f32 distance { std::numeric_limits<f32>::max() };
 
 		usize material_index { 0 };
+		/// Where the hit is seen from, the camera of the view being rendered, for view dependent shading.
+		math::Vector<f32, 3> eye {};
 	};
 
     struct Sphere final {
@@ -74,18 +84,10 @@ namespace raytracer {
     };
 
     struct Mesh final {
-        math::Vector<f32, 3> position;
-        std::vector<math::Vector<f32, 3>> vertices;
-        std::vector<std::array<usize, 3>> faces;
-        f32 scale { 1.f };
-        math::Angle<f32> pitch { 0.f };
-        math::Angle<f32> yaw { 0.f };
-        math::Angle<f32> roll { 0.f };
-
         enum class Shading {
             Flat,
             Smooth
-        } shading { Shading::Flat };
+        };
 
         struct BvhNode final {
             math::Vector<f32, 3> bound_min;
@@ -98,105 +100,234 @@ namespace raytracer {
             Box<BvhNode> right;
         };
 
-        Box<BvhNode> bvh;
+        /// The local space geometry of a mesh along with its acceleration structure.
+        ///
+        /// It is immutable once built and shared between every mesh instancing it, so loading the same
+        /// asset repeatedly or placing it in the world many times keeps a single copy in memory.
+        struct Geometry final {
+            std::vector<math::Vector<f32, 3>> vertices;
+            std::vector<std::array<usize, 3>> faces;
+            Shading shading { Shading::Flat };
+            Box<BvhNode> bvh;
+
+          private:
+            static void compute_bounds(
+                std::span<const math::Vector<f32, 3>> vertices,
+                std::span<const std::array<usize, 3>> faces,
+                math::Vector<f32, 3>& out_min,
+                math::Vector<f32, 3>& out_max
+            ) {
+                using Vector = math::Vector<f32, 3>;
+                // Silly name because the preprocessor exists and defines INFINITY. I hate C++.
+                constexpr static f32 INF = std::numeric_limits<f32>::infinity();
+
+                out_min = {  INF,  INF,  INF };
+                out_max = { -INF, -INF, -INF };
+
+                for (auto const& face : faces) {
+                    for (usize idx : face) {
+                        const auto& v = vertices[idx];
+                        for (i32 a = 0; a < 3; a += 1) {
+                            out_min[a] = std::min(out_min[a], v[a]);
+                            out_max[a] = std::max(out_max[a], v[a]);
+                        }
+                    }
+                }
+            }
 
-      private:
-        static void compute_bounds(
-            std::span<const math::Vector<f32, 3>> vertices,
-            std::span<const std::array<usize, 3>> faces,
-            math::Vector<f32, 3>& out_min,
-            math::Vector<f32, 3>& out_max
-        ) {
-            using Vector = math::Vector<f32, 3>;
-            // Silly name because the preprocessor exists and defines INFINITY. I hate C++.
-            constexpr static f32 INF = std::numeric_limits<f32>::infinity();
-
-            out_min = {  INF,  INF,  INF };
-            out_max = { -INF, -INF, -INF };
-
-            for (auto const& face : faces) {
-                for (usize idx : face) {
-                    const auto& v = vertices[idx];
-                    for (i32 a = 0; a < 3; a += 1) {
-                        out_min[a] = std::min(out_min[a], v[a]);
-                        out_max[a] = std::max(out_max[a], v[a]);
+            static auto partition_faces(
+                std::span<const math::Vector<f32, 3>> vertices,
+                std::span<std::array<usize, 3>> faces,
+                i32 axis,
+                f32 split
+            ) -> usize {
+                usize i = 0;
+                usize j = faces.size();
+
+                while (i < j) {
+                    const auto& f = faces[i];
+                    math::Vector<f32, 3> c = (vertices[f[0]] + vertices[f[1]] + vertices[f[2]]) / 3.f;
+
+                    if (c[axis] < split) {
+                        i += 1;
+                    } else {
+                        j -= 1;
+                        std::swap(faces[i], faces[j]);
                     }
                 }
+
+                return i;
             }
-        }
 
-        static auto partition_faces(
-            std::span<const math::Vector<f32, 3>> vertices,
-            std::span<std::array<usize, 3>> faces,
-            i32 axis,
-            f32 split
-        ) -> usize {
-            usize i = 0;
-            usize j = faces.size();
+            static auto build_bvh(
+                std::span<const math::Vector<f32, 3>> vertices,
+                std::span<std::array<usize, 3>> faces,
+                usize face_offset,
+                usize leaf_size = 4
+            ) -> Box<Mesh::BvhNode> {
+                using Node = Mesh::BvhNode;
+                auto node = Box<Node>::make();
 
-            while (i < j) {
-                const auto& f = faces[i];
-                math::Vector<f32, 3> c = (vertices[f[0]] + vertices[f[1]] + vertices[f[2]]) / 3.f;
+                // Compute bounding box
+                compute_bounds(vertices, faces, node->bound_min, node->bound_max);
 
-                if (c[axis] < split) {
-                    i += 1;
-                } else {
-                    j -= 1;
-                    std::swap(faces[i], faces[j]);
-                }
-            }
+                node->face_index = face_offset;
+                node->face_count = faces.size();
 
-            return i;
-        }
+                if (faces.size() <= leaf_size) return node;
 
-        static auto build_bvh(
-            std::span<const math::Vector<f32, 3>> vertices,
-            std::span<std::array<usize, 3>> faces,
-            usize face_offset,
-            usize leaf_size = 4
-        ) -> Box<Mesh::BvhNode> {
-            using Node = Mesh::BvhNode;
-            auto node = Box<Node>::make();
+                // Choose axis with largest extent
+                math::Vector<f32, 3> extent = node->bound_max - node->bound_min;
+                i32 axis = 0;
+                if (extent[1] > extent[axis]) axis = 1;
+                if (extent[2] > extent[axis]) axis = 2;
 
-            // Compute bounding box
-            compute_bounds(vertices, faces, node->bound_min, node->bound_max);
+                f32 split = (node->bound_min[axis] + node->bound_max[axis]) * 0.5f;
 
-            node->face_index = face_offset;
-            node->face_count = faces.size();
+                // Partition in-place
+                usize mid = partition_faces(vertices, faces, axis, split);
 
-            if (faces.size() <= leaf_size) return node;
+                // If partition fails (all on one side), make leaf
+                if (mid == 0 or mid == faces.size()) return node;
 
-            // Choose axis with largest extent
-            math::Vector<f32, 3> extent = node->bound_max - node->bound_min;
-            i32 axis = 0;
-            if (extent[1] > extent[axis]) axis = 1;
-            if (extent[2] > extent[axis]) axis = 2;
+                auto left_span  = faces.first(mid);
+                auto right_span = faces.last(faces.size() - mid);
+
+                node->left = build_bvh(vertices, left_span, face_offset, leaf_size);
+                node->right = build_bvh(vertices, right_span, face_offset + mid, leaf_size);
+
+                return node;
+            }
+
+          public:
+            void compute_bvh() {
+                if (faces.empty()) {
+                    bvh = Box<BvhNode>();
+                    return;
+                }
+                bvh = build_bvh(vertices, faces, 0);
+            }
 
-            f32 split = (node->bound_min[axis] + node->bound_max[axis]) * 0.5f;
+            bool intersect_bvh(
+                BvhNode const* node,
+                math::Vector<f32, 3> const& origin,
+                math::Vector<f32, 3> const& dir,
+                math::Vector<f32, 3> const& dir_inv,
+                f32& best_distance,
+                Hit& best_hit
+            ) const {
+                f32 tmin, tmax;
+                if (!intersect_aabb(origin, dir_inv, node->bound_min, node->bound_max, tmin, tmax))
+                    return false;
+
+                bool hit_any = false;
+
+                // Leaf node
+                if (!node->left && !node->right) {
+                    for (usize i = 0; i < node->face_count; i++) {
+                        auto const& face = faces[node->face_index + i];
+                        auto const& v0 = vertices[face[0]];
+                        auto const& v1 = vertices[face[1]];
+                        auto const& v2 = vertices[face[2]];
+
+                        if (auto hit = intersect_triangle(origin, dir, v0, v1, v2)) {
+                            if (hit->distance < best_distance) {
+                                best_distance = hit->distance;
+                                best_hit = *hit;
+                                hit_any = true;
+                            }
+                        }
+                    }
+                } else {
+                    if (node->left)
+                        hit_any |= intersect_bvh(node->left.raw(), origin, dir, dir_inv, best_distance, best_hit);
+                    if (node->right)
+                        hit_any |= intersect_bvh(node->right.raw(), origin, dir, dir_inv, best_distance, best_hit);
+                }
 
-            // Partition in-place
-            usize mid = partition_faces(vertices, faces, axis, split);
+                return hit_any;
+            }
 
-            // If partition fails (all on one side), make leaf
-            if (mid == 0 or mid == faces.size()) return node;
 
-            auto left_span  = faces.first(mid);
-            auto right_span = faces.last(faces.size() - mid);
+            /// Writes a binary representation of the geometry, including the flattened BVH so it
+            /// doesn't have to be rebuilt when read back.
+            void serialize(io::BinaryWriter& out) const {
+                out.reserve(16 + vertices.size() * 12 + faces.size() * 24);
+                out.u64(vertices.size());
+                out.u64(faces.size());
+                out.u8(u8(shading));
+                for (auto const& v : vertices) { out.f32(v[0]); out.f32(v[1]); out.f32(v[2]); }
+                for (auto const& f : faces) { out.u64(f[0]); out.u64(f[1]); out.u64(f[2]); }
+
+                // Preorder, each node followed by its children if it has any.
+                const auto node = [&out] (this auto const& node, BvhNode const* n) -> void {
+                    out.boolean(n != nullptr);
+                    if (not n) return;
+                    for (i32 a = 0; a < 3; a += 1) out.f32(n->bound_min[a]);
+                    for (i32 a = 0; a < 3; a += 1) out.f32(n->bound_max[a]);
+                    out.u64(n->face_index);
+                    out.u64(n->face_count);
+                    node(n->left.raw());
+                    node(n->right.raw());
+                };
+                node(bvh.raw());
+            }
 
-            node->left = build_bvh(vertices, left_span, face_offset, leaf_size);
-            node->right = build_bvh(vertices, right_span, face_offset + mid, leaf_size);
+            /// Reads geometry back from its binary representation.
+            ///
+            /// Throws `std::out_of_range` if the data is truncated or refers to vertices or faces it doesn't have.
+            static auto deserialize(io::BinaryReader& in) -> Geometry {
+                Geometry ret;
+                const u64 vertex_count = in.u64();
+                const u64 face_count = in.u64();
+                ret.shading = in.u8() ? Shading::Smooth : Shading::Flat;
+                // Divided rather than multiplied so corrupt counts can't overflow their way past the check.
+                if (vertex_count > in.remaining() / 12 or face_count > (in.remaining() - vertex_count * 12) / 24)
+                    throw std::out_of_range("Mesh::Geometry");
+
+                ret.vertices.reserve(vertex_count);
+                for (u64 i = 0; i < vertex_count; i += 1) {
+                    const f32 x = in.f32();
+                    const f32 y = in.f32();
+                    const f32 z = in.f32();
+                    ret.vertices.emplace_back(x, y, z);
+                }
 
-            return node;
-        }
+                ret.faces.reserve(face_count);
+                for (u64 i = 0; i < face_count; i += 1) {
+                    const usize a = in.u64();
+                    const usize b = in.u64();
+                    const usize c = in.u64();
+                    if (a >= vertex_count or b >= vertex_count or c >= vertex_count)
+                        throw std::out_of_range("Mesh::Geometry");
+                    ret.faces.push_back({ a, b, c });
+                }
 
-      public:
-        void compute_bvh() {
-            if (faces.empty()) {
-                bvh = Box<BvhNode>();
-                return;
+                const auto node = [&in, face_count] (this auto const& node, u32 depth) -> Box<BvhNode> {
+                    if (depth > 128) throw std::out_of_range("Mesh::Geometry");
+                    if (not in.boolean()) return Box<BvhNode>();
+                    auto n = Box<BvhNode>::make();
+                    for (i32 a = 0; a < 3; a += 1) n->bound_min[a] = in.f32();
+                    for (i32 a = 0; a < 3; a += 1) n->bound_max[a] = in.f32();
+                    n->face_index = in.u64();
+                    n->face_count = in.u64();
+                    if (n->face_index + n->face_count > face_count) throw std::out_of_range("Mesh::Geometry");
+                    n->left = node(depth + 1);
+                    n->right = node(depth + 1);
+                    return n;
+                };
+                ret.bvh = node(0);
+
+                return ret;
             }
-            bvh = build_bvh(vertices, faces, 0);
-        }
+        };
+
+        math::Vector<f32, 3> position;
+        std::shared_ptr<const Geometry> geometry;
+        f32 scale { 1.f };
+        math::Angle<f32> pitch { 0.f };
+        math::Angle<f32> yaw { 0.f };
+        math::Angle<f32> roll { 0.f };
 
         static bool intersect_aabb(
             math::Vector<f32, 3> const& origin,
@@ -260,46 +391,6 @@ namespace raytracer {
             return hit;
         }
 
-        bool intersect_bvh(
-            BvhNode const* node,
-            math::Vector<f32, 3> const& origin,
-            math::Vector<f32, 3> const& dir,
-            math::Vector<f32, 3> const& dir_inv,
-            f32& best_distance,
-            Hit& best_hit
-        ) const {
-            f32 tmin, tmax;
-            if (!intersect_aabb(origin, dir_inv, node->bound_min, node->bound_max, tmin, tmax))
-                return false;
-
-            bool hit_any = false;
-
-            // Leaf node
-            if (!node->left && !node->right) {
-                for (usize i = 0; i < node->face_count; i++) {
-                    auto const& face = faces[node->face_index + i];
-                    auto const& v0 = vertices[face[0]];
-                    auto const& v1 = vertices[face[1]];
-                    auto const& v2 = vertices[face[2]];
-
-                    if (auto hit = intersect_triangle(origin, dir, v0, v1, v2)) {
-                        if (hit->distance < best_distance) {
-                            best_distance = hit->distance;
-                            best_hit = *hit;
-                            hit_any = true;
-                        }
-                    }
-                }
-            } else {
-                if (node->left)
-                    hit_any |= intersect_bvh(node->left.raw(), origin, dir, dir_inv, best_distance, best_hit);
-                if (node->right)
-                    hit_any |= intersect_bvh(node->right.raw(), origin, dir, dir_inv, best_distance, best_hit);
-            }
-
-            return hit_any;
-        }
-
         math::Matrix<f32, 4, 4> local_to_world() const {
             using Matrix = math::Matrix<f32, 4, 4>;
 
@@ -315,7 +406,7 @@ namespace raytracer {
         }
 
         auto intersect(math::Vector<f32, 3> origin, math::Vector<f32, 3> direction) const -> std::optional<Hit> {
-            if (not bvh) return std::nullopt;
+            if (not geometry or not geometry->bvh) return std::nullopt;
 
             auto world_to_local_mat = world_to_local();
             math::Vector<f32, 4> o4 { origin,    1.f };
@@ -332,7 +423,7 @@ namespace raytracer {
             f32 best_distance = std::numeric_limits<f32>::max();
             Hit best_hit;
 
-            if (intersect_bvh(bvh.raw(), local_origin, local_dir, local_dir_inv, best_distance, best_hit)) {
+            if (geometry->intersect_bvh(geometry->bvh.raw(), local_origin, local_dir, local_dir_inv, best_distance, best_hit)) {
                 // Convert hit point and normal back to world space
                 auto local_to_world_mat = local_to_world();
                 math::Vector<f32, 4> hit4 { best_hit.origin[0], best_hit.origin[1], best_hit.origin[2], 1.0f };
@@ -349,6 +440,273 @@ namespace raytracer {
         }
     };
 
+    /// A mesh whose geometry lives in a treelet file and is paged in on demand during traversal.
+    ///
+    /// Only the top-level tree is resident, so a mesh of any size can be rendered within a fixed
+    /// memory budget at the cost of reading from disk whenever rays wander into evicted geometry.
+    /// The file is produced from an in-memory mesh with `bake`, typically once on a machine with
+    /// enough memory for it, and then opened wherever it's rendered.
+    ///
+    /// It must not outlive the Io it was opened with.
+    struct StreamedMesh final {
+        math::Vector<f32, 3> position;
+        f32 scale { 1.f };
+        math::Angle<f32> pitch { 0.f };
+        math::Angle<f32> yaw { 0.f };
+        math::Angle<f32> roll { 0.f };
+
+        std::shared_ptr<treelet::Cache> cache;
+
+      private:
+        using Node = treelet::Node;
+
+        static auto node_of(Mesh::BvhNode const& node) -> Node {
+            return Node {
+                .bound_min = { node.bound_min[0], node.bound_min[1], node.bound_min[2] },
+                .bound_max = { node.bound_max[0], node.bound_max[1], node.bound_max[2] },
+            };
+        }
+
+        /// Flattens the subtree into a self-contained treelet with locally renumbered vertices.
+        static auto cut_treelet(Mesh::Geometry const& geometry, Mesh::BvhNode const& root) -> treelet::Treelet {
+            treelet::Treelet ret;
+            std::unordered_map<usize, u32> remap;
+
+            for (usize i = 0; i < root.face_count; i += 1) {
+                const auto& face = geometry.faces[root.face_index + i];
+                std::array<u32, 3> local;
+                for (usize v = 0; v < 3; v += 1) {
+                    const auto [it, inserted] = remap.try_emplace(face[v], u32(ret.vertices.size()));
+                    if (inserted) ret.vertices.push_back(geometry.vertices[face[v]]);
+                    local[v] = it->second;
+                }
+                ret.faces.push_back(local);
+            }
+
+            const auto flatten = [&] (this auto const& flatten, Mesh::BvhNode const& node) -> u32 {
+                const u32 index = u32(ret.nodes.size());
+                ret.nodes.push_back(node_of(node));
+
+                if (not node.left and not node.right) {
+                    ret.nodes[index].kind = Node::Leaf;
+                    ret.nodes[index].first = u32(node.face_index - root.face_index);
+                    ret.nodes[index].second = u32(node.face_count);
+                } else {
+                    const u32 left = flatten(*node.left);
+                    const u32 right = flatten(*node.right);
+                    ret.nodes[index].kind = Node::Interior;
+                    ret.nodes[index].first = left;
+                    ret.nodes[index].second = right;
+                }
+                return index;
+            };
+            flatten(root);
+
+            return ret;
+        }
+
+        auto local_to_world() const -> math::Matrix<f32, 4, 4> {
+            using Matrix = math::Matrix<f32, 4, 4>;
+
+            return Matrix::scaling(scale, scale, scale)
+                 * Matrix::rotation(Matrix::RotationAxis::Pitch, pitch)
+                 * Matrix::rotation(Matrix::RotationAxis::Yaw, yaw)
+                 * Matrix::rotation(Matrix::RotationAxis::Roll, roll)
+                 * Matrix::translation(position.x(), position.y(), position.z());
+        }
+
+        static auto bounds_of(Node const& node) -> std::pair<math::Vector<f32, 3>, math::Vector<f32, 3>> {
+            return {
+                { node.bound_min[0], node.bound_min[1], node.bound_min[2] },
+                { node.bound_max[0], node.bound_max[1], node.bound_max[2] },
+            };
+        }
+
+        void intersect_treelet(
+            treelet::Treelet const& treelet,
+            math::Vector<f32, 3> const& origin,
+            math::Vector<f32, 3> const& dir,
+            math::Vector<f32, 3> const& dir_inv,
+            f32& best_distance,
+            Hit& best_hit
+        ) const {
+            // Trees are validated to be shallow enough for the stack when they're opened.
+            u32 stack[treelet::MAX_DEPTH];
+            usize depth = 0;
+            stack[depth++] = 0;
+
+            while (depth > 0) {
+                auto const& node = treelet.nodes[stack[--depth]];
+                const auto [bmin, bmax] = bounds_of(node);
+
+                f32 tmin, tmax;
+                if (not Mesh::intersect_aabb(origin, dir_inv, bmin, bmax, tmin, tmax) or tmin > best_distance) continue;
+
+                if (node.kind == Node::Leaf) {
+                    for (u32 i = 0; i < node.second; i += 1) {
+                        auto const& face = treelet.faces[node.first + i];
+                        if (auto hit = Mesh::intersect_triangle(
+                            origin, dir, treelet.vertices[face[0]], treelet.vertices[face[1]], treelet.vertices[face[2]]
+                        )) {
+                            if (hit->distance < best_distance) {
+                                best_distance = hit->distance;
+                                best_hit = *hit;
+                            }
+                        }
+                    }
+                } else {
+                    stack[depth++] = node.second;
+                    stack[depth++] = node.first;
+                }
+            }
+        }
+
+      public:
+        /// Writes the mesh geometry out as a treelet file.
+        ///
+        /// Subtrees of the mesh BVH with at most `treelet_faces` faces become treelets, everything above
+        /// them is the resident top-level tree. The BVH is computed first if the mesh doesn't have one.
+        ///
+        /// Throws `std::invalid_argument` for meshes without faces, and `std::length_error` if the BVH is
+        /// too deep for traversal to open the file again.
+        static void bake(Io& io, Mesh const& mesh, std::string_view path, usize treelet_faces = 4096) {
+            if (not mesh.geometry or mesh.geometry->faces.empty()) {
+                throw std::invalid_argument("StreamedMesh::bake: the mesh has no faces");
+            }
+
+            Mesh::Geometry const* geometry = mesh.geometry.get();
+            Mesh::Geometry built;
+            if (not geometry->bvh) {
+                built.vertices = geometry->vertices;
+                built.faces = geometry->faces;
+                built.shading = geometry->shading;
+                built.compute_bvh();
+                geometry = &built;
+            }
+
+            std::vector<Node> top;
+            std::vector<treelet::Treelet> treelets;
+
+            {
+                const auto build = [&] (this auto const& build, Mesh::BvhNode const& node) -> u32 {
+                    const u32 index = u32(top.size());
+                    top.push_back(node_of(node));
+
+                    if (node.face_count <= treelet_faces or (not node.left and not node.right)) {
+                        top[index].kind = Node::Link;
+                        top[index].first = u32(treelets.size());
+                        treelets.push_back(cut_treelet(*geometry, node));
+                    } else {
+                        const u32 left = build(*node.left);
+                        const u32 right = build(*node.right);
+                        top[index].kind = Node::Interior;
+                        top[index].first = left;
+                        top[index].second = right;
+                    }
+                    return index;
+                };
+                build(*geometry->bvh);
+            }
+
+            const auto too_deep = [] (std::span<const Node> nodes) { return treelet::depth_of(nodes) > treelet::MAX_DEPTH; };
+            if (too_deep(top) or std::ranges::any_of(treelets, [&] (auto const& t) { return too_deep(t.nodes); })) {
+                throw std::length_error("StreamedMesh::bake: the BVH is deeper than treelet::MAX_DEPTH");
+            }
+
+            std::vector<treelet::Entry> directory;
+            u64 offset = sizeof(treelet::Header) + top.size() * sizeof(Node) + treelets.size() * sizeof(treelet::Entry);
+            for (auto const& t : treelets) {
+                const auto entry = treelet::Entry {
+                    .offset = offset,
+                    .node_count = u32(t.nodes.size()),
+                    .vertex_count = u32(t.vertices.size()),
+                    .face_count = u32(t.faces.size()),
+                };
+                directory.push_back(entry);
+                offset += entry.byte_size();
+            }
+
+            std::vector<u8> out;
+            out.reserve(offset);
+            treelet::append(out, treelet::Header { treelet::MAGIC, treelet::VERSION, u32(top.size()), u32(treelets.size()) });
+            treelet::append<Node>(out, top);
+            treelet::append<treelet::Entry>(out, directory);
+            for (auto const& t : treelets) {
+                treelet::append<Node>(out, t.nodes);
+                for (auto const& v : t.vertices) {
+                    const f32 raw[3] { v[0], v[1], v[2] };
+                    treelet::append<f32>(out, raw);
+                }
+                treelet::append<std::array<u32, 3>>(out, t.faces);
+            }
+
+            io.write_file(path, out);
+        }
+
+        /// Opens a treelet file, keeping at most roughly `budget_bytes` of geometry resident.
+        static auto open(Io& io, std::string_view path, usize budget_bytes) -> StreamedMesh {
+            StreamedMesh ret;
+            ret.cache = std::make_shared<treelet::Cache>(io.open_file(path), budget_bytes);
+            return ret;
+        }
+
+        auto intersect(math::Vector<f32, 3> origin, math::Vector<f32, 3> direction) const -> std::optional<Hit> {
+            if (not cache) return std::nullopt;
+
+            const auto local_to_world_mat = local_to_world();
+            const auto world_to_local_mat = local_to_world_mat.inverse();
+            math::Vector<f32, 4> o4 { origin,    1.f };
+            math::Vector<f32, 4> d4 { direction, 0.f };
+
+            const math::Vector<f32, 3> local_origin = (o4 * world_to_local_mat);
+            const math::Vector<f32, 3> local_dir = (d4 * world_to_local_mat).normalized();
+            const auto local_dir_inv = math::Vector<f32, 3> {
+                1.0f / local_dir[0],
+                1.0f / local_dir[1],
+                1.0f / local_dir[2]
+            };
+
+            f32 best_distance = std::numeric_limits<f32>::max();
+            Hit best_hit;
+
+            // Front to back order doesn't matter for correctness, but keeping the traversal shallow
+            // and culling by the best distance so far avoids paging in treelets we would not hit.
+            const auto top = cache->top_level();
+            // Trees are validated to be shallow enough for the stack when they're opened.
+            u32 stack[treelet::MAX_DEPTH];
+            usize depth = 0;
+            stack[depth++] = 0;
+
+            while (depth > 0) {
+                auto const& node = top[stack[--depth]];
+                const auto [bmin, bmax] = bounds_of(node);
+
+                f32 tmin, tmax;
+                if (not Mesh::intersect_aabb(local_origin, local_dir_inv, bmin, bmax, tmin, tmax) or tmin > best_distance) continue;
+
+                if (node.kind == Node::Link) {
+                    const auto treelet = cache->acquire(node.first);
+                    intersect_treelet(*treelet, local_origin, local_dir, local_dir_inv, best_distance, best_hit);
+                } else {
+                    stack[depth++] = node.second;
+                    stack[depth++] = node.first;
+                }
+            }
+
+            if (best_distance == std::numeric_limits<f32>::max()) return std::nullopt;
+
+            // Convert hit point and normal back to world space
+            math::Vector<f32, 4> hit4 { best_hit.origin[0], best_hit.origin[1], best_hit.origin[2], 1.0f };
+            math::Vector<f32, 4> normal4 { best_hit.normal[0], best_hit.normal[1], best_hit.normal[2], 0.0f };
+
+            best_hit.origin = (hit4 * local_to_world_mat);
+            best_hit.normal = (normal4 * local_to_world_mat).normalized();
+            best_hit.distance = (best_hit.origin - origin).magnitude();
+
+            return best_hit;
+        }
+    };
+
     struct PointLight final {
         math::Vector<f32, 3> position;
         raytracer::Color color;
@@ -457,7 +815,7 @@ namespace raytracer {
         return os;
     }
 
-    using Shape = std::variant<Sphere, Plane, Mesh>;
+    using Shape = std::variant<Sphere, Plane, Mesh, StreamedMesh>;
 
     template <typename T, typename... Us> concept any_of = (std::same_as<T, Us> or ...);
 
@@ -473,11 +831,11 @@ namespace raytracer {
         return begin;
     }
 
-    static auto load_mesh(Io& io, std::string_view path) -> Mesh {
-        const auto data = io.read_file(path);
+    /// Parses the vertices, faces and shading of a Wavefront OBJ file and builds its BVH.
+    static auto parse_obj(std::span<const u8> data) -> Mesh::Geometry {
         const auto obj = std::string_view((char const*) data.data(), data.size());
 
-        Mesh mesh;
+        Mesh::Geometry geometry;
 
         for (const auto line : obj | std::views::split('\n')) {
             auto components = line | std::views::split(' ');
@@ -493,25 +851,33 @@ namespace raytracer {
 
             if (const auto id = next()) {
                 if (id == "v") {
-                    mesh.vertices.emplace_back(
+                    geometry.vertices.emplace_back(
                         std::stof(std::string(next().value())),
                         std::stof(std::string(next().value())),
                         std::stof(std::string(next().value()))
                     );
                 } else if (id == "f") {
-                    mesh.faces.push_back({
+                    geometry.faces.push_back({
                         std::stoul(std::string(next().value())) - 1,
                         std::stoul(std::string(next().value())) - 1,
                         std::stoul(std::string(next().value())) - 1
                     });
                 } else if (id == "s") [[unlikely]] {
-                    mesh.shading = std::stoul(std::string(next().value())) ? Mesh::Shading::Smooth : Mesh::Shading::Flat;
+                    geometry.shading = std::stoul(std::string(next().value())) ? Mesh::Shading::Smooth : Mesh::Shading::Flat;
                 }
             }
         }
 
-        mesh.compute_bvh();
+        geometry.compute_bvh();
 
+        return geometry;
+    }
+
+    /// Loads an OBJ mesh through the shared asset cache, so loading the same file again only
+    /// creates a new instance of the already parsed geometry.
+    static auto load_mesh(Io& io, std::string_view path) -> Mesh {
+        Mesh mesh;
+        mesh.geometry = io::AssetCache::shared().load<Mesh::Geometry>(io, path, "obj-mesh-v1", parse_obj);
         return mesh;
     }
 
@@ -533,6 +899,10 @@ namespace raytracer {
         math::Angle<f32> fov { math::deg(80.f).radians() };
         bool checkerboard { true };
         bool shadows { true };
+        std::optional<draw::ToneMap> tone_map;
+        /// The linear light of each view while tone mapping, kept between frames like the targets are
+        /// so checkerboarding can leave half of it alone.
+        mutable std::vector<draw::HdrImage> hdr_targets;
         BsdfMaterial::Mode bsdf_mode { BsdfMaterial::Mode::Default };
         BsdfMaterial::GiMode gi_mode { BsdfMaterial::GiMode::None };
 
@@ -577,7 +947,7 @@ namespace raytracer {
             operator bool () const { return world; }
         };
 
-        template <any_of<Sphere, Plane, Mesh> Object, subtype<Material> Mat> auto add(Object object, Mat material) -> Ref<Object> {
+        template <any_of<Sphere, Plane, Mesh, StreamedMesh> Object, subtype<Material> Mat> auto add(Object object, Mat material) -> Ref<Object> {
             usize material_index;
             if (const auto it = indirect_find(material_data.begin(), material_data.end(), material); it != material_data.end()) {
                 material_index = it - material_data.begin();
@@ -590,7 +960,7 @@ namespace raytracer {
             return { this, object_data.size() - 1 };
         }
 
-        template <any_of<Sphere, Plane, Mesh> Object> auto add(Object object) -> Ref<Object> {
+        template <any_of<Sphere, Plane, Mesh, StreamedMesh> Object> auto add(Object object) -> Ref<Object> {
             return add(object, SolidColorMaterial(draw::color::pico::RED));
         }
 
@@ -612,6 +982,16 @@ namespace raytracer {
             return fov;
         }
 
+        /// Renders in linear light and tone maps it into the targets when set, otherwise colors are
+        /// clamped straight into them.
+        void set_tone_map(std::optional<draw::ToneMap> value) {
+            tone_map = value;
+        }
+
+        auto get_tone_map() const -> std::optional<draw::ToneMap> {
+            return tone_map;
+        }
+
         void set_checkerboard(bool value) {
             checkerboard = value;
         }
@@ -740,7 +1120,7 @@ namespace raytracer {
                                     };
                                 }
                             }
-                        } else if constexpr (std::same_as<T, Mesh>) {
+                        } else if constexpr (std::same_as<T, Mesh> or std::same_as<T, StreamedMesh>) {
                             if (auto hit = object.intersect(origin, direction)) {
                                 if (not best_hit or hit->distance < best_hit->distance) {
                                     hit->material_index = material;
@@ -756,45 +1136,154 @@ namespace raytracer {
             return best_hit;
         }
 
-        void draw(Io& io, rt::Input const& input, draw::Ref<draw::Image> target) const {
-            const f32 aspect = f32(target.width()) / f32(target.height());
-            const f32 half_fov_tan = std::tan(fov.radians() / 2.f);
-            const i32 width = target.width();
-            const i32 height = target.height();
-            const auto rotation_matrix = this->rotation_matrix();
+        /// A camera to render the world from.
+        struct View final {
+            math::Vector<f32, 3> position;
+            /// Turns directions relative to the camera, with +Z forward and +Y up, into world directions.
+            math::Matrix<f32, 3, 3> rotation;
+            math::Angle<f32> fov;
+        };
 
-            const u32 thread_count = std::thread::hardware_concurrency();
-            const i32 rows_per_thread = (height + thread_count - 1) / thread_count;
+        /// The view from the world's own camera.
+        auto camera_view() const -> View {
+            return View { camera_position, rotation_matrix(), fov };
+        }
 
-            std::vector<std::jthread> threads;
-            threads.reserve(thread_count);
+        /// A stereo pair around the world's camera, the left eye first, with the eyes `separation` apart
+        /// along the camera's horizontal axis.
+        auto stereo_views(f32 separation) const -> std::array<View, 2> {
+            const auto center = camera_view();
+            const auto right = math::Vector<f32, 3> { 1.f, 0.f, 0.f } * center.rotation;
+            auto left_eye = center, right_eye = center;
+            left_eye.position = center.position - right * (separation / 2.f);
+            right_eye.position = center.position + right * (separation / 2.f);
+            return { left_eye, right_eye };
+        }
 
-            for (u32 t = 0; t < thread_count; t += 1) {
-                const i32 y_start = t * rows_per_thread;
-                const i32 y_end = std::min(height, y_start + rows_per_thread);
+        /// The six faces of a cube map around a point, in the order +X, -X, +Y, -Y, +Z, -Z.
+        ///
+        /// Side faces are upright, the +Y face has -Z up and the -Y face +Z up. Faces should be rendered
+        /// into square targets for the 90 degree fields of view to meet at the edges.
+        static auto cube_views(math::Vector<f32, 3> position) -> std::array<View, 6> {
+            using Matrix = math::Matrix<f32, 3, 3>;
+            const auto face = [position] (f32 pitch, f32 yaw) -> View {
+                return View {
+                    position,
+                    Matrix::rotation(Matrix::RotationAxis::Pitch, math::deg(pitch))
+                        * Matrix::rotation(Matrix::RotationAxis::Yaw, math::deg(yaw)),
+                    math::deg(90.f),
+                };
+            };
+            return { face(0.f, -90.f), face(0.f, 90.f), face(90.f, 0.f), face(-90.f, 0.f), face(0.f, 0.f), face(0.f, 180.f) };
+        }
 
-                threads.emplace_back([&, y_start, y_end] {
-                    for (i32 y = y_start; y < y_end; y += 1) {
-                        for (i32 x = 0; x < width; x += 1) {
-                            if (checkerboard and (x + y + input.counter()) % 2 == 0) continue;
+        /// Renders several views into their targets in a single pass.
+        ///
+        /// All views share one set of threads, the acceleration structures and the material table.
+        /// Rows of every view are handed out in small batches from a shared counter, so threads which
+        /// finish their part of one view carry on with the next rather than idling while views of
+        /// different cost complete. Views and targets are paired up in order.
+        void draw_views(Io& io, rt::Input const& input, std::span<const View> views, std::span<draw::Ref<draw::Image>> targets) const {
+            constexpr i32 BATCH_ROWS = 4;
+
+            struct Pass final {
+                math::Vector<f32, 3> position;
+                math::Matrix<f32, 3, 3> rotation;
+                f32 aspect, half_fov_tan;
+                i32 width, height;
+                usize first_batch;
+            };
+
+            const usize view_count = std::min(views.size(), targets.size());
+            std::vector<Pass> passes;
+            passes.reserve(view_count);
+            usize batch_count = 0;
+            for (usize i = 0; i < view_count; i += 1) {
+                const i32 width = targets[i].width();
+                const i32 height = targets[i].height();
+                passes.push_back(Pass {
+                    .position = views[i].position,
+                    .rotation = views[i].rotation,
+                    .aspect = f32(width) / f32(height),
+                    .half_fov_tan = std::tan(views[i].fov.radians() / 2.f),
+                    .width = width,
+                    .height = height,
+                    .first_batch = batch_count,
+                });
+                batch_count += usize((height + BATCH_ROWS - 1) / BATCH_ROWS);
+            }
+
+            if (tone_map) {
+                if (hdr_targets.size() < view_count) hdr_targets.resize(view_count);
+                for (usize i = 0; i < view_count; i += 1) hdr_targets[i].resize(passes[i].width, passes[i].height);
+            }
 
-                            const f32 ndc_x = (2.f * (x + .5f) / width - 1.f) * aspect;
-                            const f32 ndc_y = (1.f - 2.f * (y + .5f) / height);
+            const auto render_rows = [&] (usize index, i32 y_start, i32 y_end) {
+                Pass const& pass = passes[index];
+                auto& target = targets[index];
 
-                            const f32 px = ndc_x * half_fov_tan;
-                            const f32 py = ndc_y * half_fov_tan;
+                for (i32 y = y_start; y < y_end; y += 1) {
+                    for (i32 x = 0; x < pass.width; x += 1) {
+                        if (checkerboard and (x + y + input.counter()) % 2 == 0) continue;
 
-                            math::Vector<f32, 3> forward_ray_dir = { px, py, 1.f };
-                            forward_ray_dir = forward_ray_dir.normalized();
-                            const auto ray_dir = forward_ray_dir * rotation_matrix;
+                        const f32 ndc_x = (2.f * (x + .5f) / pass.width - 1.f) * pass.aspect;
+                        const f32 ndc_y = (1.f - 2.f * (y + .5f) / pass.height);
 
-                            if (const auto hit = cast_ray(camera_position, ray_dir)) {
-                                target | draw::pixel(x, y, material_data[hit->material_index]->shade(*hit, *this, 0));
+                        const f32 px = ndc_x * pass.half_fov_tan;
+                        const f32 py = ndc_y * pass.half_fov_tan;
+
+                        math::Vector<f32, 3> forward_ray_dir = { px, py, 1.f };
+                        forward_ray_dir = forward_ray_dir.normalized();
+                        const auto ray_dir = forward_ray_dir * pass.rotation;
+
+                        if (auto hit = cast_ray(pass.position, ray_dir)) {
+                            hit->eye = pass.position;
+                            const auto color = material_data[hit->material_index]->shade(*hit, *this, 0);
+                            if (tone_map) {
+                                hdr_targets[index].set(x, y, { color.r, color.g, color.b });
+                            } else {
+                                target | draw::pixel(x, y, color);
                             }
+                        } else if (tone_map) {
+                            // Mapping writes whole rows, misses have to be black rather than left over.
+                            hdr_targets[index].set(x, y, {});
                         }
                     }
+                }
+
+                // The rows are still in cache, mapping them now saves another sweep over the frame.
+                if (tone_map) tone_map->apply_rows(hdr_targets[index], target, y_start, y_end);
+            };
+
+            std::atomic<usize> next_batch { 0 };
+            const u32 thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+
+            std::vector<std::jthread> threads;
+            threads.reserve(thread_count);
+
+            for (u32 t = 0; t < thread_count; t += 1) {
+                threads.emplace_back([&] {
+                    usize index = 0;
+                    for (usize batch; (batch = next_batch.fetch_add(1, std::memory_order_relaxed)) < batch_count;) {
+                        // Batches are taken in increasing order, so the view only ever moves forward.
+                        while (index + 1 < passes.size() and batch >= passes[index + 1].first_batch) index += 1;
+                        const i32 y_start = i32(batch - passes[index].first_batch) * BATCH_ROWS;
+                        render_rows(index, y_start, std::min(passes[index].height, y_start + BATCH_ROWS));
+                    }
                 });
             }
+
+            if (tone_map) {
+                threads.clear(); // Joins them.
+                for (usize i = 0; i < view_count; i += 1) {
+                    draw::detail::damage_region(targets[i], 0, 0, passes[i].width, passes[i].height);
+                }
+            }
+        }
+
+        void draw(Io& io, rt::Input const& input, draw::Ref<draw::Image> target) const {
+            const View view = camera_view();
+            draw_views(io, input, std::span(&view, 1), std::span(&target, 1));
         }
     };
 }
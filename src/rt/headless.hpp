@@ -0,0 +1,164 @@
+// A game executor without a window, for machines without a display.
+#pragma once
+#include <primitive>
+#include <io>
+#include <draw>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <limits>
+#include <optional>
+#include <utility>
+#include "instance.hpp"
+#include "shared.hpp"
+
+namespace rt {
+    /// Input which never has any keys held or a mouse, only the poll counter advances.
+    class HeadlessInput final : public Input {
+      public:
+        void poll() {
+            advance_counter();
+        }
+    };
+
+    /// Timings of a headless run, all in milliseconds.
+    struct HeadlessStats final {
+        usize frames { 0 };
+        f64 init_time { 0 };
+        f64 total_time { 0 };
+        /// Summed over all frames.
+        f64 update_time { 0 };
+        f64 draw_time { 0 };
+        /// Of update and draw together.
+        f64 min_frame { 0 };
+        f64 max_frame { 0 };
+        f64 mean_frame { 0 };
+    };
+
+    namespace detail {
+        /// The loop behind the headless executors, which leaves where each frame is drawn to the
+        /// function of signature (frame: usize, target: Image&, draw: (Image&) -> void) -> void.
+        /// It calls `draw` exactly once, either on the offscreen target or on memory of its own.
+        inline auto run_headless(
+            Instance auto& game,
+            Io& io,
+            i32 width,
+            i32 height,
+            usize frames,
+            auto present,
+            InputLog const& log
+        ) -> HeadlessStats {
+            static std::atomic<bool> is_running = false;
+
+            if (is_running.exchange(true)) {
+                throw RunError { RunError::Reason::AlreadyRunning };
+            }
+
+            const auto milliseconds_since = [] (std::chrono::steady_clock::time_point start) -> f64 {
+                return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+            };
+
+            HeadlessStats stats;
+            stats.min_frame = std::numeric_limits<f64>::infinity();
+            const auto run_start = std::chrono::steady_clock::now();
+
+            try {
+                const auto init_start = std::chrono::steady_clock::now();
+                game.init(io);
+                stats.init_time = milliseconds_since(init_start);
+
+                auto recorder = log.record ? std::optional<InputRecorder>(std::in_place, io, *log.record) : std::nullopt;
+                auto replay = log.replay ? std::optional<ReplayInput>(std::in_place, io, *log.replay) : std::nullopt;
+
+                auto target = draw::Image(width, height);
+                auto input = HeadlessInput {};
+                Input const& current = replay ? static_cast<Input const&>(*replay) : input;
+
+                for (usize frame = 0; frame < frames; frame += 1) {
+                    if (replay and replay->finished()) break;
+
+                    const auto update_start = std::chrono::steady_clock::now();
+                    if (replay) replay->poll(); else input.poll();
+                    if (recorder) recorder->record(current);
+                    game.update(io, current);
+                    const f64 update_time = milliseconds_since(update_start);
+
+                    f64 draw_time = 0;
+                    present(frame, target, [&] (draw::Image& into) {
+                        const auto draw_start = std::chrono::steady_clock::now();
+                        game.draw(io, current, into);
+                        draw_time = milliseconds_since(draw_start);
+                    });
+
+                    stats.frames += 1;
+                    stats.update_time += update_time;
+                    stats.draw_time += draw_time;
+                    stats.min_frame = std::min(stats.min_frame, update_time + draw_time);
+                    stats.max_frame = std::max(stats.max_frame, update_time + draw_time);
+                }
+            } catch (...) {
+                is_running.store(false);
+                throw;
+            }
+
+            stats.total_time = milliseconds_since(run_start);
+            if (stats.frames == 0) stats.min_frame = 0;
+            else stats.mean_frame = (stats.update_time + stats.draw_time) / f64(stats.frames);
+
+            is_running.store(false);
+            return stats;
+        }
+    }
+
+    /// Runs a game for a fixed number of frames into an offscreen image of the given size.
+    ///
+    /// Nothing here touches SDL, so together with an Io like PosixIo it runs where there is no display
+    /// at all. Frames are not paced, each is updated and drawn as fast as possible, after which the
+    /// function of signature (frame: usize, target: Image const&) -> void is called with the result,
+    /// e.g. to submit it to an rt::SequenceWriter or an rt::VideoStream.
+    ///
+    /// Input can be recorded or replayed through the log, a replay ends the run early once it's finished.
+    inline auto run_headless(
+        Instance auto& game,
+        Io& io,
+        i32 width,
+        i32 height,
+        usize frames,
+        std::invocable<usize, draw::Image const&> auto after_frame,
+        InputLog const& log = {}
+    ) -> HeadlessStats {
+        return detail::run_headless(game, io, width, height, frames, [&after_frame] (usize frame, draw::Image& target, auto draw_frame) {
+            draw_frame(target);
+            after_frame(frame, std::as_const(target));
+        }, log);
+    }
+
+    /// Runs a game for a fixed number of frames straight into a shared frame ring, at the size of the ring.
+    ///
+    /// Games which draw every pixel, see Instance, draw directly into the next slot without any copies.
+    /// The rest draw into an offscreen image which is then submitted, since a slot holds whatever frame
+    /// was last written to it rather than the previous one.
+    inline auto run_headless(Instance auto& game, Io& io, SharedFrameRing& ring, usize frames, InputLog const& log = {}) -> HeadlessStats {
+        return detail::run_headless(game, io, ring.width(), ring.height(), frames, [&game, &ring] (usize, draw::Image& target, auto draw_frame) {
+            if constexpr (requires { { game.draws_every_pixel() } -> std::convertible_to<bool>; }) {
+                if (game.draws_every_pixel()) {
+                    ring.render([&draw_frame] (SharedFrameRing::Frame& slot) {
+                        auto frame = draw::Image::borrow(slot.pixels().data(), slot.width(), slot.height(), slot.width());
+                        draw_frame(frame);
+                    });
+                    return;
+                }
+            }
+            draw_frame(target);
+            ring.submit(target);
+        }, log);
+    }
+
+    /// Runs a game for a fixed number of frames into an offscreen image of the given size.
+    ///
+    /// This overload discards the frames and is only useful for the timings.
+    inline auto run_headless(Instance auto& game, Io& io, i32 width, i32 height, usize frames, InputLog const& log = {}) -> HeadlessStats {
+        return run_headless(game, io, width, height, frames, [] (usize, draw::Image const&) {}, log);
+    }
+}
@@ -10,11 +10,30 @@
 #include <string>
 #include <optional>
 #include <atomic>
-#include <unordered_set>
+#include <algorithm>
+#include <array>
+#include <bitset>
 #include <iostream>
 #include <chrono>
 #include <numeric>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <string_view>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
 #include <SDL3/SDL.h>
+#include "pacing.hpp"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 /// An implemenation of Io purely in terms of SDL3. This is very convenient because we don't need
 /// to depend on the standard library or the operating system in SDL3 based projects.
@@ -56,6 +75,132 @@ class SdlIo final : public Io {
         if (not ret) throw Error();
         return (void*) ret;
     }
+
+    void perform_write_file(char const* path, std::span<const u8> data) override {
+        if (not SDL_SaveFile(path, data.data(), data.size())) throw Error();
+    }
+
+    void perform_create_directory(char const* path) override {
+        if (not SDL_CreateDirectory(path)) throw Error();
+    }
+
+    /// SDL streams have a single cursor so positional reads have to seek and read under a lock.
+    struct OpenFile final {
+        SDL_IOStream* stream;
+        std::mutex lock;
+    };
+
+    auto perform_open_file(char const* path) -> void* override {
+        auto stream = SDL_IOFromFile(path, "rb");
+        if (not stream) throw Error();
+        return new OpenFile { stream };
+    }
+
+    void perform_close_file(void* file) override {
+        const auto open = (OpenFile*) file;
+        SDL_CloseIO(open->stream);
+        delete open;
+    }
+
+    auto perform_file_size(void* file) -> u64 override {
+        const auto size = SDL_GetIOSize(((OpenFile*) file)->stream);
+        if (size < 0) throw Error();
+        return u64(size);
+    }
+
+    void perform_read_file_at(void* file, u64 offset, std::span<u8> out) override {
+        const auto open = (OpenFile*) file;
+        std::lock_guard guard { open->lock };
+        if (SDL_SeekIO(open->stream, Sint64(offset), SDL_IO_SEEK_SET) < 0) throw Error();
+        if (SDL_ReadIO(open->stream, out.data(), out.size()) != out.size()) throw Error();
+    }
+
+    /// SDL can't open the standard output so it's adapted as a custom stream.
+    static auto standard_output() -> SDL_IOStream* {
+        SDL_IOStreamInterface methods;
+        SDL_INIT_INTERFACE(&methods);
+        methods.write = [] (void*, void const* data, std::size_t size, SDL_IOStatus* status) -> std::size_t {
+            const auto written = std::fwrite(data, 1, size, stdout);
+            if (written < size) *status = SDL_IO_STATUS_ERROR;
+            return written;
+        };
+        methods.flush = [] (void*, SDL_IOStatus* status) -> bool {
+            if (std::fflush(stdout) == 0) return true;
+            *status = SDL_IO_STATUS_ERROR;
+            return false;
+        };
+        methods.close = [] (void*) -> bool {
+            return std::fflush(stdout) == 0;
+        };
+        return SDL_OpenIO(&methods, nullptr);
+    }
+
+    auto perform_open_output(char const* path) -> void* override {
+        const auto stream = std::string_view(path) == "-" ? standard_output() : SDL_IOFromFile(path, "wb");
+        if (not stream) throw Error();
+        return stream;
+    }
+
+    void perform_write_output(void* output, std::span<const u8> data) override {
+        if (SDL_WriteIO((SDL_IOStream*) output, data.data(), data.size()) != data.size()) throw Error();
+    }
+
+    void perform_flush_output(void* output) override {
+        if (not SDL_FlushIO((SDL_IOStream*) output)) throw Error();
+    }
+
+    void perform_close_output(void* output) override {
+        SDL_CloseIO((SDL_IOStream*) output);
+    }
+
+    /// SDL has no notion of shared memory so this goes straight to POSIX where available.
+    auto perform_map_shared_memory(char const* name, usize size) -> void* override {
+        #ifndef _WIN32
+        shm_unlink(name);
+        const int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) {
+            SDL_SetError("shm_open: %s", std::strerror(errno));
+            throw Error();
+        }
+        if (ftruncate(fd, off_t(size)) != 0) {
+            SDL_SetError("ftruncate: %s", std::strerror(errno));
+            close(fd);
+            shm_unlink(name);
+            throw Error();
+        }
+        const auto data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            SDL_SetError("mmap: %s", std::strerror(errno));
+            shm_unlink(name);
+            throw Error();
+        }
+        return data;
+        #else
+        SDL_Unsupported();
+        throw Error();
+        #endif
+    }
+
+    void perform_unmap_shared_memory(char const* name, void* data, usize size) override {
+        #ifndef _WIN32
+        munmap(data, size);
+        shm_unlink(name);
+        #endif
+    }
+
+    /// SDL can't map files so they are loaded whole instead.
+    auto perform_map_file(char const* path, usize& size) -> void const* override {
+        std::size_t count;
+        const auto data = SDL_LoadFile(path, &count);
+        if (not data) throw Error();
+        size = count;
+        return data;
+    }
+
+    void perform_unmap_file(void const* data, usize size) override {
+        SDL_free((void*) data);
+    }
 };
 
 
@@ -80,6 +225,9 @@ namespace rt {
         Minus = Dash,
     };
 
+    /// The number of distinct keys, which index the input state arrays.
+    inline constexpr usize KEY_COUNT = usize(Key::F12) + 1;
+
     struct KeyIterator final {
         class Impl final {
             u32 current;
@@ -112,142 +260,141 @@ namespace rt {
         }
 
         auto end() -> Impl {
-            return Impl { u32(Key::Escape) + 1 };
+            return Impl { u32(KEY_COUNT) };
         }
     };
 
     constexpr auto all_keys() -> KeyIterator {
         return KeyIterator();
     }
-
-    struct KeyState final {
-        Key key;
-        i32 pressed_for { 0 };
-
-        static auto from(Key key) -> KeyState {
-            return KeyState { key };
-        }
-
-        auto pressed() const -> KeyState {
-            return KeyState { key, pressed_for + 1 };
-        }
-
-        friend constexpr auto operator==(rt::KeyState const& lhs, rt::KeyState const& rhs) noexcept -> bool {
-            return lhs.key == rhs.key;
-        }
-
-        friend constexpr auto operator!=(rt::KeyState const& lhs, rt::KeyState const& rhs) noexcept -> bool {
-            return !(lhs == rhs);
-        }
-    };
 }
 
-template <> struct std::hash<rt::KeyState> {
-    std::size_t operator()(rt::KeyState const& state) const noexcept {
-        return std::hash<u16>()(u16(state.key));
-    }
-};
-
 namespace rt::detail {
-    inline auto get_key(Key key) -> bool {
-        const auto keys = SDL_GetKeyboardState(nullptr);
-        switch (key) {
-            case Key::A: return keys[SDL_SCANCODE_A];
-            case Key::B: return keys[SDL_SCANCODE_B];
-            case Key::C: return keys[SDL_SCANCODE_C];
-            case Key::D: return keys[SDL_SCANCODE_D];
-            case Key::E: return keys[SDL_SCANCODE_E];
-            case Key::F: return keys[SDL_SCANCODE_F];
-            case Key::G: return keys[SDL_SCANCODE_G];
-            case Key::H: return keys[SDL_SCANCODE_H];
-            case Key::I: return keys[SDL_SCANCODE_I];
-            case Key::J: return keys[SDL_SCANCODE_J];
-            case Key::K: return keys[SDL_SCANCODE_K];
-            case Key::L: return keys[SDL_SCANCODE_L];
-            case Key::M: return keys[SDL_SCANCODE_M];
-            case Key::N: return keys[SDL_SCANCODE_N];
-            case Key::O: return keys[SDL_SCANCODE_O];
-            case Key::P: return keys[SDL_SCANCODE_P];
-            case Key::Q: return keys[SDL_SCANCODE_Q];
-            case Key::R: return keys[SDL_SCANCODE_R];
-            case Key::S: return keys[SDL_SCANCODE_S];
-            case Key::T: return keys[SDL_SCANCODE_T];
-            case Key::U: return keys[SDL_SCANCODE_U];
-            case Key::V: return keys[SDL_SCANCODE_V];
-            case Key::W: return keys[SDL_SCANCODE_W];
-            case Key::X: return keys[SDL_SCANCODE_X];
-            case Key::Y: return keys[SDL_SCANCODE_Y];
-            case Key::Z: return keys[SDL_SCANCODE_Z];
-
-            case Key::Backspace: return keys[SDL_SCANCODE_BACKSPACE];
-            case Key::Left:      return keys[SDL_SCANCODE_LEFT];
-            case Key::Right:     return keys[SDL_SCANCODE_RIGHT];
-            case Key::Up:        return keys[SDL_SCANCODE_UP];
-            case Key::Down:      return keys[SDL_SCANCODE_DOWN];
-
-            case Key::Num0: return keys[SDL_SCANCODE_0];
-            case Key::Num1: return keys[SDL_SCANCODE_1];
-            case Key::Num2: return keys[SDL_SCANCODE_2];
-            case Key::Num3: return keys[SDL_SCANCODE_3];
-            case Key::Num4: return keys[SDL_SCANCODE_4];
-            case Key::Num5: return keys[SDL_SCANCODE_5];
-            case Key::Num6: return keys[SDL_SCANCODE_6];
-            case Key::Num7: return keys[SDL_SCANCODE_7];
-            case Key::Num8: return keys[SDL_SCANCODE_8];
-            case Key::Num9: return keys[SDL_SCANCODE_9];
-
-            case Key::Comma:        return keys[SDL_SCANCODE_COMMA];
-            case Key::Period:       return keys[SDL_SCANCODE_PERIOD];
-            case Key::Slash:        return keys[SDL_SCANCODE_SLASH];
-            case Key::Backslash:    return keys[SDL_SCANCODE_BACKSLASH];
-            case Key::Equals:       return keys[SDL_SCANCODE_EQUALS];
-            case Key::Dash:         return keys[SDL_SCANCODE_MINUS];
-            case Key::BracketLeft:  return keys[SDL_SCANCODE_LEFTBRACKET];
-            case Key::BracketRight: return keys[SDL_SCANCODE_RIGHTBRACKET];
-            case Key::Semicolon:    return keys[SDL_SCANCODE_SEMICOLON];
-            case Key::Quote:        return keys[SDL_SCANCODE_APOSTROPHE];
-            case Key::Space:        return keys[SDL_SCANCODE_SPACE];
-            case Key::Shift:        return keys[SDL_SCANCODE_LSHIFT] or keys[SDL_SCANCODE_RSHIFT];
-            case Key::Meta:         return keys[SDL_SCANCODE_LGUI] or keys[SDL_SCANCODE_RGUI];
-            case Key::Control:      return keys[SDL_SCANCODE_LCTRL] or keys[SDL_SCANCODE_RCTRL];
-            case Key::Option:       return keys[SDL_SCANCODE_LALT] or keys[SDL_SCANCODE_RALT];
-            case Key::Tab:          return keys[SDL_SCANCODE_TAB];
-            case Key::Enter:        return keys[SDL_SCANCODE_RETURN];
-            case Key::Escape:       return keys[SDL_SCANCODE_ESCAPE];
-
-            case Key::F1:  return keys[SDL_SCANCODE_F1];
-            case Key::F2:  return keys[SDL_SCANCODE_F2];
-            case Key::F3:  return keys[SDL_SCANCODE_F3];
-            case Key::F4:  return keys[SDL_SCANCODE_F4];
-            case Key::F5:  return keys[SDL_SCANCODE_F5];
-            case Key::F6:  return keys[SDL_SCANCODE_F6];
-            case Key::F7:  return keys[SDL_SCANCODE_F7];
-            case Key::F8:  return keys[SDL_SCANCODE_F8];
-            case Key::F9:  return keys[SDL_SCANCODE_F9];
-            case Key::F10: return keys[SDL_SCANCODE_F10];
-            case Key::F11: return keys[SDL_SCANCODE_F11];
-            case Key::F12: return keys[SDL_SCANCODE_F12];
-        }
-    }
+    /// The scancodes of every key, modifiers have one on either side of the keyboard.
+    inline constexpr std::pair<SDL_Scancode, Key> SCANCODES[] = {
+        { SDL_SCANCODE_A, Key::A },
+        { SDL_SCANCODE_B, Key::B },
+        { SDL_SCANCODE_C, Key::C },
+        { SDL_SCANCODE_D, Key::D },
+        { SDL_SCANCODE_E, Key::E },
+        { SDL_SCANCODE_F, Key::F },
+        { SDL_SCANCODE_G, Key::G },
+        { SDL_SCANCODE_H, Key::H },
+        { SDL_SCANCODE_I, Key::I },
+        { SDL_SCANCODE_J, Key::J },
+        { SDL_SCANCODE_K, Key::K },
+        { SDL_SCANCODE_L, Key::L },
+        { SDL_SCANCODE_M, Key::M },
+        { SDL_SCANCODE_N, Key::N },
+        { SDL_SCANCODE_O, Key::O },
+        { SDL_SCANCODE_P, Key::P },
+        { SDL_SCANCODE_Q, Key::Q },
+        { SDL_SCANCODE_R, Key::R },
+        { SDL_SCANCODE_S, Key::S },
+        { SDL_SCANCODE_T, Key::T },
+        { SDL_SCANCODE_U, Key::U },
+        { SDL_SCANCODE_V, Key::V },
+        { SDL_SCANCODE_W, Key::W },
+        { SDL_SCANCODE_X, Key::X },
+        { SDL_SCANCODE_Y, Key::Y },
+        { SDL_SCANCODE_Z, Key::Z },
+
+        { SDL_SCANCODE_BACKSPACE, Key::Backspace },
+        { SDL_SCANCODE_LEFT, Key::Left },
+        { SDL_SCANCODE_RIGHT, Key::Right },
+        { SDL_SCANCODE_UP, Key::Up },
+        { SDL_SCANCODE_DOWN, Key::Down },
+
+        { SDL_SCANCODE_0, Key::Num0 },
+        { SDL_SCANCODE_1, Key::Num1 },
+        { SDL_SCANCODE_2, Key::Num2 },
+        { SDL_SCANCODE_3, Key::Num3 },
+        { SDL_SCANCODE_4, Key::Num4 },
+        { SDL_SCANCODE_5, Key::Num5 },
+        { SDL_SCANCODE_6, Key::Num6 },
+        { SDL_SCANCODE_7, Key::Num7 },
+        { SDL_SCANCODE_8, Key::Num8 },
+        { SDL_SCANCODE_9, Key::Num9 },
+
+        { SDL_SCANCODE_COMMA, Key::Comma },
+        { SDL_SCANCODE_PERIOD, Key::Period },
+        { SDL_SCANCODE_SLASH, Key::Slash },
+        { SDL_SCANCODE_BACKSLASH, Key::Backslash },
+        { SDL_SCANCODE_EQUALS, Key::Equals },
+        { SDL_SCANCODE_MINUS, Key::Dash },
+        { SDL_SCANCODE_LEFTBRACKET, Key::BracketLeft },
+        { SDL_SCANCODE_RIGHTBRACKET, Key::BracketRight },
+        { SDL_SCANCODE_SEMICOLON, Key::Semicolon },
+        { SDL_SCANCODE_APOSTROPHE, Key::Quote },
+        { SDL_SCANCODE_SPACE, Key::Space },
+        { SDL_SCANCODE_LSHIFT, Key::Shift },
+        { SDL_SCANCODE_RSHIFT, Key::Shift },
+        { SDL_SCANCODE_LGUI, Key::Meta },
+        { SDL_SCANCODE_RGUI, Key::Meta },
+        { SDL_SCANCODE_LCTRL, Key::Control },
+        { SDL_SCANCODE_RCTRL, Key::Control },
+        { SDL_SCANCODE_LALT, Key::Option },
+        { SDL_SCANCODE_RALT, Key::Option },
+        { SDL_SCANCODE_TAB, Key::Tab },
+        { SDL_SCANCODE_RETURN, Key::Enter },
+        { SDL_SCANCODE_ESCAPE, Key::Escape },
+
+        { SDL_SCANCODE_F1, Key::F1 },
+        { SDL_SCANCODE_F2, Key::F2 },
+        { SDL_SCANCODE_F3, Key::F3 },
+        { SDL_SCANCODE_F4, Key::F4 },
+        { SDL_SCANCODE_F5, Key::F5 },
+        { SDL_SCANCODE_F6, Key::F6 },
+        { SDL_SCANCODE_F7, Key::F7 },
+        { SDL_SCANCODE_F8, Key::F8 },
+        { SDL_SCANCODE_F9, Key::F9 },
+        { SDL_SCANCODE_F10, Key::F10 },
+        { SDL_SCANCODE_F11, Key::F11 },
+        { SDL_SCANCODE_F12, Key::F12 },
+    };
+
+    /// Maps scancodes back to keys, holding KEY_COUNT for scancodes without a key.
+    inline constexpr auto KEYS_BY_SCANCODE = [] {
+        std::array<u8, SDL_SCANCODE_COUNT> ret;
+        ret.fill(u8(KEY_COUNT));
+        for (const auto& [scancode, key] : SCANCODES) ret[scancode] = u8(key);
+        return ret;
+    }();
+
+    static_assert([] {
+        std::array<bool, KEY_COUNT> mapped {};
+        for (const auto& [scancode, key] : SCANCODES) mapped[usize(key)] = true;
+        return std::ranges::all_of(mapped, [] (bool value) { return value; });
+    }(), "Every key needs a scancode");
+    static_assert(KEY_COUNT < 0xFF);
 }
 
 namespace rt {
+    /// The state of the keys and mouse as of the latest poll.
+    ///
+    /// Keys are tracked in fixed arrays indexed by Key, so polling and queries are a few array accesses
+    /// and never allocate.
     class Input {
         std::optional<Mouse> mouse_state;
-        std::unordered_set<KeyState> keys;
+        std::bitset<KEY_COUNT> held;
+        /// The number of polls each held key has been held for, zero on the poll it was pressed.
+        std::array<i32, KEY_COUNT> held_for {};
         usize poll_counter { 0 };
 
       protected:
         void press(Key key) {
-            if (auto existing = keys.extract(KeyState::from(key))) {
-                keys.insert(existing.value().pressed());
+            const usize index = usize(key);
+            if (held[index]) {
+                held_for[index] += 1;
             } else {
-                keys.insert(KeyState::from(key));
+                held[index] = true;
+                held_for[index] = 0;
             }
         }
 
         void unpress(Key key) {
-            (void) keys.extract(KeyState::from(key));
+            held[usize(key)] = false;
+            held_for[usize(key)] = 0;
         }
 
         auto mouse() -> std::optional<Mouse>& {
@@ -269,30 +416,25 @@ namespace rt {
         }
 
         auto key_pressed(Key key) const -> bool {
-            if (auto k = keys.find(KeyState::from(key)); k != keys.end()) {
-                return (*k).pressed_for == 0;
-            } else {
-                return false;
-            }
+            return held[usize(key)] and held_for[usize(key)] == 0;
         }
 
         auto key_held(Key key) const -> bool {
-            return keys.find(KeyState::from(key)) != keys.end();
+            return held[usize(key)];
         }
 
         auto key_repeating(Key key, i32 delay, i32 interval) const -> bool {
-            // If there is no matching key, it can't be pressed.
-            const auto ki = keys.find(KeyState::from(key));
-            if (ki == keys.end()) return false;
-            const auto k = *ki;
+            // If the key isn't held, it can't be pressed.
+            if (not held[usize(key)]) return false;
+            const i32 pressed_for = held_for[usize(key)];
 
-            // If the key matched and it was just pressed it counts as the first press before the delay.
-            if (k.pressed_for == 0) return true;
+            // If the key was just pressed it counts as the first press before the delay.
+            if (pressed_for == 0) return true;
             // If we have not reached the delay the input doesn't count.
-            if (k.pressed_for < delay) return false;
+            if (pressed_for < delay) return false;
 
             // Now we can start repeating at the specified interval.
-            const auto start = k.pressed_for - delay;
+            const auto start = pressed_for - delay;
             return start % interval == 0; // start.isMultiple(of: interval)
         }
 
@@ -301,8 +443,28 @@ namespace rt {
         }
     };
 
+    /// Input fed by SDL keyboard events, which the executor forwards to `handle`.
     class ManagedSdlInput final : public Input {
+        /// Which scancodes are down according to the events so far.
+        std::bitset<SDL_SCANCODE_COUNT> scancodes_down;
+        /// How many scancodes of each key are down, so a modifier stays held until both sides are released.
+        std::array<u8, KEY_COUNT> down {};
+
       public:
+        void handle(SDL_Event const& event) {
+            if (event.type != SDL_EVENT_KEY_DOWN and event.type != SDL_EVENT_KEY_UP) return;
+            const usize scancode = usize(event.key.scancode);
+            if (scancode >= SDL_SCANCODE_COUNT) return;
+            const u8 key = detail::KEYS_BY_SCANCODE[scancode];
+            if (key >= KEY_COUNT) return;
+
+            // Key repeats arrive as further key down events and must not count twice.
+            const bool pressed = event.type == SDL_EVENT_KEY_DOWN;
+            if (scancodes_down[scancode] == pressed) return;
+            scancodes_down[scancode] = pressed;
+            down[key] = pressed ? down[key] + 1 : down[key] - 1;
+        }
+
         void poll() {
             // TODO: Apply scale to mouse input. Unused in this game anyway so it's whatever.
             f32 x, y;
@@ -315,7 +477,7 @@ namespace rt {
             };
 
             for (const auto key : all_keys()) {
-                if (detail::get_key(key)) {
+                if (down[usize(key)] > 0) {
                     this->press(key);
                 } else {
                     this->unpress(key);
@@ -326,136 +488,194 @@ namespace rt {
         }
     };
 
-    /// Returns a concrete subtype of Input with a managed `poll()` interface.
-    /// The exact type could change in the future.
-    inline auto input() {
-        return ManagedSdlInput {};
+    /// The layout of input logs written by InputRecorder and read by ReplayInput.
+    ///
+    /// A header of the magic, version and key count as u32 values is followed by one record per tick:
+    /// the held keys as a little endian bitmask of `(KEY_COUNT + 7) / 8` bytes, a byte of flags and,
+    /// if the mouse was present, its position as two i32 values.
+    namespace input_log {
+        inline constexpr u32 MAGIC = 0x4E495452; // "RTIN"
+        inline constexpr u32 VERSION = 1;
+        inline constexpr usize MASK_SIZE = (KEY_COUNT + 7) / 8;
+
+        enum Flags : u8 {
+            HAS_MOUSE = 1 << 0,
+            MOUSE_LEFT = 1 << 1,
+            MOUSE_RIGHT = 1 << 2,
+        };
     }
 
-    inline auto timestamp() -> f64 {
-        auto now = std::chrono::steady_clock::now().time_since_epoch();
-        return std::chrono::duration<f64, std::milli>(now).count();
-    }
+    /// Records the state of an input every tick, to be played back with ReplayInput.
+    ///
+    /// Records are buffered and written out in large chunks, the rest is written when it's destroyed.
+    /// It must not outlive the Io it was created with.
+    class InputRecorder final {
+        Io::Output output;
+        io::BinaryWriter buffer;
+        usize tick_count { 0 };
 
-    class Timer final {
-        f64 prev_time;
+        static constexpr usize CHUNK_SIZE = 64 * 1024;
 
       public:
-        Timer() : prev_time(timestamp()) {}
-
-        auto elapsed() const -> f64 {
-            return timestamp() - prev_time;
+        InputRecorder(Io& io [[clang::lifetimebound]], std::string_view path) : output(io.open_output(path)) {
+            buffer.reserve(CHUNK_SIZE);
+            buffer.u32(input_log::MAGIC);
+            buffer.u32(input_log::VERSION);
+            buffer.u32(u32(KEY_COUNT));
         }
 
-        auto lap() -> f64 {
-            const auto e = elapsed();
-            prev_time = timestamp();
-            return e;
+        InputRecorder(InputRecorder const&) = delete;
+        auto operator=(InputRecorder const&) -> InputRecorder& = delete;
+
+        ~InputRecorder() {
+            try { flush(); } catch (Io::Error const&) {}
         }
-    };
 
-    /// Accumulates time steps to guess the refresh rate since the SDL platform does not
-    /// provide any way to query it otherwise.
-    class HeuristicTimestampBasedRefreshRateLock final {
-        std::vector<f64> acc;
-        f64 previous_stamp { timestamp() };
-        mutable f64 phase { 0.0 };
+        /// Appends the current state of the input, call it once per tick right after polling.
+        void record(Input const& input) {
+            u8 mask[input_log::MASK_SIZE] {};
+            for (const auto key : all_keys()) {
+                if (input.key_held(key)) mask[usize(key) / 8] |= u8(1 << (usize(key) % 8));
+            }
+            buffer.bytes(mask);
+
+            if (const auto& mouse = input.mouse()) {
+                buffer.u8(u8(
+                    input_log::HAS_MOUSE
+                    | (mouse->left ? input_log::MOUSE_LEFT : 0)
+                    | (mouse->right ? input_log::MOUSE_RIGHT : 0)
+                ));
+                buffer.i32(mouse->x);
+                buffer.i32(mouse->y);
+            } else {
+                buffer.u8(0);
+            }
 
-      public:
-        enum CommonRate : u32 {
-            Hz30  = 30,
-            Hz60  = 60,
-            Hz75  = 75,
-            Hz90  = 90,
-            Hz120 = 120,
-            Hz144 = 144,
-            Hz240 = 240,
-            Hz360 = 360,
-        };
+            tick_count += 1;
+            if (buffer.size() >= CHUNK_SIZE) flush();
+        }
 
-        f64 estimated_millis;
-        u32 estimated_hertz;
-        std::optional<CommonRate> common_rate;
+        /// Writes out everything recorded so far.
+        void flush() {
+            if (buffer.size() == 0) return;
+            output.write(buffer.view());
+            output.flush();
+            buffer = io::BinaryWriter();
+            buffer.reserve(CHUNK_SIZE);
+        }
 
-        void lap() {
-            // SAFETY: Just an environment query.
-            const f64 stamp = timestamp();
-            const f64 elapsed = stamp - previous_stamp;
+        auto ticks() const noexcept -> usize {
+            return tick_count;
+        }
+    };
 
-            acc.insert(acc.begin(), elapsed);
+    /// An error raised when an input log can't be replayed.
+    struct ReplayError final {
+        enum class Reason {
+            NotAnInputLog,
+            UnsupportedVersion,
+            /// The log was recorded with a different set of keys.
+            KeyMismatch,
+            Truncated,
+        } reason;
+        std::optional<std::string> description { std::nullopt };
+    };
 
-            previous_stamp = stamp;
+    /// Plays back an input log written by InputRecorder, one recorded tick per poll.
+    ///
+    /// Since the counter advances once per poll as well, a game updated from it sees exactly the
+    /// input it saw while recording, held durations included.
+    class ReplayInput final : public Input {
+        std::vector<u8> log;
+        io::BinaryReader reader;
 
-            if (acc.size() > 120) acc.pop_back();
+      public:
+        /// Reads the whole log up front so playback never touches the disk.
+        ReplayInput(Io& io, std::string_view path) : log(io.read_file(path)), reader(io::BinaryReader::of(log)) {
+            try {
+                if (reader.u32() != input_log::MAGIC) throw ReplayError { ReplayError::Reason::NotAnInputLog };
+                if (reader.u32() != input_log::VERSION) throw ReplayError { ReplayError::Reason::UnsupportedVersion };
+                if (reader.u32() != KEY_COUNT) throw ReplayError { ReplayError::Reason::KeyMismatch };
+            } catch (std::out_of_range const&) {
+                throw ReplayError { ReplayError::Reason::NotAnInputLog };
+            }
+        }
 
-            const f64 average = std::accumulate(acc.begin(), acc.end(), 0.0)
-                / (f64) acc.size();
+        /// Whether every recorded tick has been played back.
+        auto finished() const noexcept -> bool {
+            return reader.remaining() == 0;
+        }
 
-            const auto common_rates = {
-                Hz30, Hz60, Hz75, Hz90, Hz120, Hz144, Hz240, Hz360,
-            };
+        /// Applies the next recorded tick, or releases everything once the log is finished.
+        void poll() {
+            if (finished()) {
+                for (const auto key : all_keys()) this->unpress(key);
+                mouse() = std::nullopt;
+                advance_counter();
+                return;
+            }
+
+            try {
+                const auto mask = reader.bytes(input_log::MASK_SIZE);
+                for (const auto key : all_keys()) {
+                    if (mask[usize(key) / 8] & (1 << (usize(key) % 8))) {
+                        this->press(key);
+                    } else {
+                        this->unpress(key);
+                    }
+                }
 
-            estimated_millis = average;
-            estimated_hertz = u32(1000.0 / average);
-            for (const auto rate : common_rates) {
-                constexpr f64 ERROR = 0.5;
-                const f64 closest = 1000.0 / (f64) (u32) rate;
-                if (std::abs(average - closest) <= ERROR) {
-                    common_rate = rate; break;
+                const u8 flags = reader.u8();
+                if (flags & input_log::HAS_MOUSE) {
+                    const i32 x = reader.i32();
+                    const i32 y = reader.i32();
+                    mouse() = Mouse { x, y, (flags & input_log::MOUSE_LEFT) != 0, (flags & input_log::MOUSE_RIGHT) != 0 };
                 } else {
-                    common_rate = std::nullopt;
+                    mouse() = std::nullopt;
                 }
+            } catch (std::out_of_range const&) {
+                throw ReplayError { ReplayError::Reason::Truncated };
             }
-        }
 
-        auto compatible_with_rate(u32 desired_rate) const -> bool {
-            return (common_rate ? (u32) *common_rate : estimated_hertz) % desired_rate == 0;
+            advance_counter();
         }
+    };
 
-        /// Given a frame count and a target hertz makes an effort to invoke the provided callable
-        /// at a consistent rate in sync with the display, ideally by alternating frames on which
-        /// it attempts to draw when the rate is divisible or close to it.
-        ///
-        /// If the desired rate is incompatible and we can't evenly distribute frames it falls back on
-        /// floating point accumulation which should maintain an erroneous but better than nothing sync.
-        ///
-        /// If the rate falls below the desired rate the callable will always be invoked since we are
-        /// already failing to keep up and there is no way to provide a good experience anymore,
-        /// which will slow down.
-        ///
-        /// Passing zero as the desired rate bypasses the lock.
-        template <typename Fn> void sync(usize frame, u32 desired_rate, Fn f) const {
-            const u32 actual_hertz = common_rate ? (u32) *common_rate : estimated_hertz;
+    /// Where the executors record input to or replay it from, for reproducible runs.
+    struct InputLog final {
+        /// Records every tick of input to this path.
+        std::optional<std::string> record { std::nullopt };
+        /// Replays the ticks from this path instead of reading real input, stopping once it's finished.
+        std::optional<std::string> replay { std::nullopt };
+    };
 
-            if (desired_rate == 0 or actual_hertz < desired_rate) {
-                f();
-            } else if (not compatible_with_rate(desired_rate)) {
-                const f64 actual_rate = common_rate ? (f64) *common_rate : (1000.0 / estimated_millis);
+    /// Returns a concrete subtype of Input with a managed `poll()` interface.
+    /// The exact type could change in the future.
+    inline auto input() {
+        return ManagedSdlInput {};
+    }
 
-                if (actual_rate < 1e-6) return; // avoid division by zero
+    inline auto timestamp() -> f64 {
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration<f64, std::milli>(now).count();
+    }
 
-                const f64 increment = (f64) desired_rate / actual_rate;
-                phase += increment;
+    class Timer final {
+        f64 prev_time;
 
-                if (phase >= 1.0) {
-                    f();
-                    phase -= 1.0;
-                }
-            } else {
-                const u32 tick_frames = actual_hertz / desired_rate;
+      public:
+        Timer() : prev_time(timestamp()) {}
 
-                if (tick_frames != 0 and frame % tick_frames == 0) {
-                    f();
-                }
-            }
+        auto elapsed() const -> f64 {
+            return timestamp() - prev_time;
         }
-    };
 
-    /// Returns a concrete type implementing the refresh rate lock interface.
-    /// The exact type could change in the future.
-    inline auto refresh_rate_lock() {
-        return HeuristicTimestampBasedRefreshRateLock {};
-    }
+        auto lap() -> f64 {
+            const auto e = elapsed();
+            prev_time = timestamp();
+            return e;
+        }
+    };
 
     /// Defines a game runnable by a game executor. The default is `run(game)`.
     ///
@@ -467,6 +687,10 @@ namespace rt {
     /// The catch is, without C++20 modules, this means the run implementation must be a template,
     /// so it is impossible for it to avoid exposing SDL includes, but that's an arbitrary
     /// issue caused by being forced to support old C++.
+    ///
+    /// A game may also define `draws_every_pixel() const -> bool`, returning true on frames where its draw
+    /// overwrites the whole target. The executor then hands it texture memory to draw into directly,
+    /// the contents of which are arbitrary rather than the previous frame.
     template <typename Self>
     concept Instance = requires(Self const& self, Self& self_mut, draw::Ref<draw::Image> target, Io& io, Input const& input) {
         { self_mut.init(io) } -> std::same_as<void>;
@@ -474,6 +698,14 @@ namespace rt {
         { self.draw(io, input, target) } -> std::same_as<void>;
     };
 
+    /// A game which draws in between fixed timestep updates, given how far past the latest update the
+    /// frame is as a fraction of a step. The executor prefers this over the plain draw method.
+    template <typename Self>
+    concept InterpolatingInstance = Instance<Self>
+        and requires(Self const& self, draw::Ref<draw::Image> target, Io& io, Input const& input, f64 alpha) {
+            { self.draw(io, input, target, alpha) } -> std::same_as<void>;
+        };
+
     /// An error raised while running the game using the default executor.
     struct RunError final {
         /// The cause of the error.
@@ -496,7 +728,21 @@ namespace rt {
     /// This method was moved from Game into an environment message.
     /// A game cannot run itself, it is run by the platform it's on
     /// and can be run in many ways, this is just one implementation.
-    static void run(Instance auto& game, char const* title, i32 width, i32 height, i32 scale) {
+    ///
+    /// Input can be recorded to or replayed from a log, in which case the window closes once the
+    /// replay is finished.
+    ///
+    /// Each frame is passed to the function of signature (frame: Image const&) -> void once it's drawn,
+    /// e.g. to submit it to an rt::SharedFrameRing alongside the window.
+    inline void run(
+        Instance auto& game,
+        char const* title,
+        i32 width,
+        i32 height,
+        i32 scale,
+        InputLog const& log,
+        std::invocable<draw::Image const&> auto after_draw
+    ) {
         static std::atomic<bool> is_running = false;
 
         if (is_running.load()) {
@@ -560,8 +806,10 @@ namespace rt {
             if (texture) {
                 SDL_DestroyTexture(texture);
             }
+            // RGBA32 is the byte order of draw::Color on any host, where a packed format like ABGR8888
+            // only matches on little endian ones and would otherwise have to be swizzled on upload.
             texture = SDL_CreateTexture(
-                renderer, SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_STREAMING, w, h
+                renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, w, h
             );
             if (not texture) {
                 throw RunError {
@@ -576,13 +824,20 @@ namespace rt {
         SdlIo io;
         game.init(io);
 
+        auto recorder = log.record ? std::optional<InputRecorder>(std::in_place, io, *log.record) : std::nullopt;
+        auto replay = log.replay ? std::optional<ReplayInput>(std::in_place, io, *log.replay) : std::nullopt;
+
         SDL_Event event;
         usize frame = 0;
         bool perf_overlay = false;
-        bool heuristic_rate_lock = true;
+        bool fixed_step_pacing = true;
         auto target = draw::Image(width / scale, height / scale);
+        // Only the parts of the target drawn to are uploaded each frame.
+        target.track_damage(true);
+        std::vector<draw::Image::Region> damage;
         auto input = rt::input();
-        auto rate = rt::refresh_rate_lock();
+        Input const& current = replay ? static_cast<Input const&>(*replay) : input;
+        auto pacer = rt::frame_pacer();
 
         const auto apply_window_size = [&] {
             // We are explicitly using the scaled window size and not the
@@ -600,48 +855,57 @@ namespace rt {
                 switch (event.type) {
                     case SDL_EVENT_QUIT: goto end;
                     case SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED: apply_window_size(); break;
+                    case SDL_EVENT_KEY_DOWN:
+                    case SDL_EVENT_KEY_UP: input.handle(event); break;
                     default: break;
                 }
             }
 
-            // Ensure stable 60hz.
-            rate.lap();
+            if (replay and replay->finished()) goto end;
+
+            pacer.lap();
 
-            const auto draw_perf_overlay = [&] {
+            const auto draw_perf_overlay = [&] (draw::Image& target) {
                 std::stringstream out;
+                const auto timing = pacer.stats();
                 out << "Assumed rate: ";
-                if (rate.common_rate) out << *rate.common_rate; else out << "Unknown";
+                if (pacer.common_rate) out << *pacer.common_rate; else out << "Unknown";
                 out << std::endl
-                    << "Estimated rate: " << rate.estimated_hertz << std::endl
-                    << "Average ms: " << rate.estimated_millis << std::endl
+                    << "Estimated rate: " << pacer.estimated_hertz << std::endl
+                    << "Average ms: " << timing.mean << std::endl
+                    << "p50/p95/p99 ms: " << timing.p50 << '/' << timing.p95 << '/' << timing.p99 << std::endl
+                    << "Late presents: " << timing.late_presents << std::endl
                     << "Vsync status: " << (is_vsync ? "Enabled" : "Disabled") << std::endl
-                    << "Heuristic lock status: " << (heuristic_rate_lock ? "Enabled" : "Disabled") << std::endl
+                    << "Fixed step pacing: " << (fixed_step_pacing ? "Enabled" : "Disabled") << std::endl
                     << "Scale: " << scale << 'x' << std::endl
                     << "Resolution: " << target.width() << 'x' << target.height() << std::endl;
 
+                auto& glyphs = draw::GlyphCache::shared();
                 std::string line;
-                std::vector<std::pair<draw::Text<draw::Ref<const draw::Image>, std::string>, i32>> lines;
+                std::vector<std::pair<std::string, i32>> lines;
+                i32 greatest_width = 0;
                 for (i32 y = 8; std::getline(out, line); y += font::mine(io).height + font::mine(io).leading) {
-                    lines.emplace_back(draw::Text(line, font::mine(io)), y);
+                    greatest_width = std::max(greatest_width, glyphs.width(font::mine(io), line));
+                    lines.emplace_back(std::move(line), y);
                 }
 
-                i32 greatest_width = 0;
-                for (auto const& [text, y] : lines) if (text.width() > greatest_width) greatest_width = text.width();
-                for (auto const& [text, y] : lines) target | draw::draw(text, target.width() - 8 - greatest_width, y);
+                for (auto const& [text, y] : lines) target | draw::text(text, font::mine(io), target.width() - 8 - greatest_width, y);
             };
 
-            rate.sync(frame, heuristic_rate_lock ? 60 : 0, [&] {
-                input.poll();
+            // Updates run at a fixed 60hz regardless of the refresh rate.
+            pacer.step(fixed_step_pacing ? 60 : 0, [&] {
+                if (replay) replay->poll(); else input.poll();
+                if (recorder) recorder->record(current);
 
                 { // Process runtime specific debug options.
-                    if (input.key_pressed(Key::Num0)) {
+                    if (current.key_pressed(Key::Num0)) {
                         is_vsync = !is_vsync;
                         SDL_SetRenderVSync(renderer, is_vsync);
                     }
-                    if (input.key_pressed(Key::Num8)) heuristic_rate_lock = !heuristic_rate_lock;
-                    if (input.key_pressed(Key::Num9)) perf_overlay = !perf_overlay;
+                    if (current.key_pressed(Key::Num8)) fixed_step_pacing = !fixed_step_pacing;
+                    if (current.key_pressed(Key::Num9)) perf_overlay = !perf_overlay;
 
-                    if (bool p = input.key_pressed(Key::Plus), m = input.key_pressed(Key::Minus); p or m) {
+                    if (bool p = current.key_pressed(Key::Plus), m = current.key_pressed(Key::Minus); p or m) {
                         if (p) scale = std::min(8, scale + 1);
                         if (m) scale = std::max(1, scale - 1);
                         target | draw::clear();
@@ -649,18 +913,56 @@ namespace rt {
                     }
 
                     #ifdef _MSC_VER // Fullscreen button for a funny operating system.
-                    if (input.key_pressed(Key::F1)) SDL_SetWindowFullscreen(window, true);
+                    if (current.key_pressed(Key::F1)) SDL_SetWindowFullscreen(window, true);
                     #endif
                 }
 
-                game.update(io, input);
+                game.update(io, current);
             });
-            game.draw(io, input, target);
-            if (perf_overlay) draw_perf_overlay();
+            const auto draw_frame = [&] (draw::Image& frame) {
+                if constexpr (InterpolatingInstance<std::remove_cvref_t<decltype(game)>>) {
+                    game.draw(io, current, frame, pacer.interpolation());
+                } else {
+                    game.draw(io, current, frame);
+                }
+                if (perf_overlay) draw_perf_overlay(frame);
+                after_draw(std::as_const(frame));
+            };
 
             SDL_RenderClear(renderer);
 
-            SDL_UpdateTexture(texture, nullptr, target.raw(), u16(target.width() * sizeof(draw::Color)));
+            // Games which draw every pixel of every frame draw straight into the locked texture, which
+            // saves copying the frame. The rest draw into the target which keeps the previous frame,
+            // since locked texture memory holds arbitrary contents.
+            bool drawn = false;
+            if constexpr (requires { { game.draws_every_pixel() } -> std::convertible_to<bool>; }) {
+                void* pixels;
+                i32 pitch;
+                if (game.draws_every_pixel() and SDL_LockTexture(texture, nullptr, &pixels, &pitch)) {
+                    if (pitch % i32(sizeof(draw::Color)) == 0) {
+                        auto frame = draw::Image::borrow(
+                            (draw::Color*) pixels, target.width(), target.height(), pitch / i32(sizeof(draw::Color))
+                        );
+                        draw_frame(frame);
+                        drawn = true;
+                        // The texture no longer holds the target, all of it has to be uploaded again.
+                        target.damage_region(0, 0, target.width(), target.height());
+                    }
+                    SDL_UnlockTexture(texture);
+                }
+            }
+            if (not drawn) {
+                draw_frame(target);
+                target.take_damage(damage);
+                for (auto const& region : damage) {
+                    const SDL_Rect rect { region.x, region.y, region.w, region.h };
+                    SDL_UpdateTexture(
+                        texture, &rect,
+                        target.raw() + usize(region.y) * usize(target.stride()) + usize(region.x),
+                        target.stride() * i32(sizeof(draw::Color))
+                    );
+                }
+            }
 
             if (not SDL_RenderTexture(renderer, texture, nullptr, nullptr)) {
                 throw RunError {
@@ -676,6 +978,9 @@ namespace rt {
                 };
             }
 
+            // Without vsync nothing else holds frames back, so they're paced to the update rate instead.
+            if (not is_vsync and fixed_step_pacing) pacer.wait_for_present(60);
+
             frame += 1;
         }
     end:
@@ -687,6 +992,17 @@ namespace rt {
         is_running.store(false);
     }
 
+    /// Runs a game in the environment.
+    ///
+    /// This method was moved from Game into an environment message.
+    /// A game cannot run itself, it is run by the platform it's on
+    /// and can be run in many ways, this is just one implementation.
+    ///
+    /// This overload doesn't observe the frames.
+    inline void run(Instance auto& game, char const* title, i32 width, i32 height, i32 scale, InputLog const& log = {}) {
+        run(game, title, width, height, scale, log, [] (draw::Image const&) {});
+    }
+
     /// Runs a game in the environment.
     ///
     /// This method was moved from Game into an environment message.
@@ -694,7 +1010,7 @@ namespace rt {
     /// and can be run in many ways, this is just one implementation.
     ///
     /// This overload uses the default window size of 800x600.
-    inline void run(Instance auto& game, char const* title, i32 scale = 1) {
-        run(game, title, 800, 600, scale);
+    inline void run(Instance auto& game, char const* title, i32 scale = 1, InputLog const& log = {}) {
+        run(game, title, 800, 600, scale, log);
     }
 }
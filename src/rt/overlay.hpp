@@ -0,0 +1,107 @@
+// Retained overlays: panels of text rendered once and composited over every frame until they change.
+#pragma once
+#include <primitive>
+#include <io>
+#include <draw>
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace rt {
+    /// A panel of text lines drawn over the frame, like a HUD.
+    ///
+    /// The content is typically rebuilt every frame but rarely changes, so rendered panels are kept by
+    /// their content and only rendered again when it's new. Panels are found by hash and then confirmed
+    /// by comparing the content itself, so a collision can't show the wrong one. A few recent panels
+    /// are kept so toggling between a handful of states such as a shown and hidden section never
+    /// renders twice.
+    /// Compositing is then a single blend of the panel image over the frame.
+    class Overlay final {
+        struct Panel final {
+            u64 key { 0 };
+            u64 last_used { 0 };
+            /// The font and color are part of the key, which only says they're likely the same.
+            void const* font { nullptr };
+            draw::Color color { draw::color::CLEAR };
+            std::string content;
+            draw::Image image;
+        };
+
+        static constexpr usize CAPACITY = 4;
+
+        std::array<Panel, CAPACITY> panels;
+        usize current { 0 };
+        u64 uses { 0 };
+
+        template <draw::Plane T> static auto key_of(std::string_view content, draw::Font<T, char> const& font, draw::Color color) -> u64 {
+            const u64 salt = u64(std::hash<void const*> {}(&font)) * 0x9E3779B97F4A7C15
+                           ^ (u64(color.r) | u64(color.g) << 8 | u64(color.b) << 16 | u64(color.a) << 24);
+            // Zero marks an empty slot.
+            return (io::content_hash(std::span((u8 const*) content.data(), content.size())) ^ salt) | 1;
+        }
+
+        template <draw::Plane T> static auto render(std::string_view content, draw::Font<T, char> const& font, draw::Color color) -> draw::Image {
+            auto& glyphs = draw::GlyphCache::shared();
+            const i32 line_height = font.height + font.leading;
+
+            i32 width = 0, height = 0;
+            for (std::string_view rest = content; not rest.empty();) {
+                const usize end = std::min(rest.find('\n'), rest.size());
+                width = std::max(width, glyphs.width(font, rest.substr(0, end), color));
+                height += line_height;
+                rest.remove_prefix(std::min(end + 1, rest.size()));
+            }
+
+            auto ret = draw::Image(width, std::max(0, height - font.leading));
+            i32 y = 0;
+            for (std::string_view rest = content; not rest.empty(); y += line_height) {
+                const usize end = std::min(rest.find('\n'), rest.size());
+                ret | draw::text(rest.substr(0, end), font, 0, y, color);
+                rest.remove_prefix(std::min(end + 1, rest.size()));
+            }
+            return ret;
+        }
+
+      public:
+        /// Sets the lines of the panel, separated by newlines, rendering it only if this content hasn't
+        /// been seen recently. Returns whether it had to be rendered.
+        template <draw::Plane T> auto set(std::string_view content, draw::Font<T, char> const& font, draw::Color color = draw::color::WHITE) -> bool {
+            const u64 key = key_of(content, font, color);
+            uses += 1;
+
+            for (usize i = 0; i < CAPACITY; i += 1) {
+                Panel const& panel = panels[i];
+                if (panel.key == key and panel.font == &font and panel.color == color and panel.content == content) {
+                    panels[i].last_used = uses;
+                    current = i;
+                    return false;
+                }
+            }
+
+            const auto oldest = std::min_element(panels.begin(), panels.end(), [] (Panel const& a, Panel const& b) {
+                return a.last_used < b.last_used;
+            });
+            oldest->image = render(content, font, color);
+            oldest->key = key;
+            oldest->last_used = uses;
+            oldest->font = &font;
+            oldest->color = color;
+            oldest->content = content;
+            current = usize(oldest - panels.begin());
+            return true;
+        }
+
+        /// The panel as last set.
+        auto image() const noexcept -> draw::Image const& {
+            return panels[current].image;
+        }
+
+        /// Blends the panel over the target with its top left corner at the position.
+        template <draw::MutableRowPlane T> void composite(T& target, i32 x, i32 y) const {
+            target | draw::draw(image(), x, y);
+        }
+    };
+}
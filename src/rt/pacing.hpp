@@ -0,0 +1,200 @@
+// Frame pacing: timing history, present timing and fixed timestep updates.
+#pragma once
+#include <primitive>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <optional>
+#include <thread>
+
+namespace rt {
+    /// The durations of the most recent frames in milliseconds, kept in a fixed ring buffer.
+    template <usize N> class FrameHistory final {
+        std::array<f64, N> samples {};
+        usize head { 0 };
+        usize count { 0 };
+        f64 sum { 0 };
+
+      public:
+        void push(f64 millis) noexcept {
+            if (count == N) {
+                sum -= samples[head];
+            } else {
+                count += 1;
+            }
+            samples[head] = millis;
+            sum += millis;
+            head = (head + 1) % N;
+        }
+
+        auto size() const noexcept -> usize {
+            return count;
+        }
+
+        auto mean() const noexcept -> f64 {
+            return count == 0 ? 0 : sum / f64(count);
+        }
+
+        /// The duration below which the given fraction of frames fall, for example 0.99 for the 99th percentile.
+        ///
+        /// This sorts a copy of the samples on the stack, it's meant for occasional reporting.
+        auto percentile(f64 fraction) const noexcept -> f64 {
+            if (count == 0) return 0;
+            std::array<f64, N> sorted;
+            std::copy_n(samples.begin(), count, sorted.begin());
+            const usize index = std::min(count - 1, usize(std::clamp(fraction, 0.0, 1.0) * f64(count - 1) + 0.5));
+            std::nth_element(sorted.begin(), sorted.begin() + index, sorted.begin() + count);
+            return sorted[index];
+        }
+    };
+
+    /// Paces frames of the default executor.
+    ///
+    /// It measures each frame into a FrameHistory from which the refresh rate is estimated, runs updates
+    /// on a fixed timestep independent of how often frames are drawn, and when nothing else limits the
+    /// frame rate waits for the next present time by sleeping most of the way and spinning the rest.
+    class FramePacer final {
+        using Clock = std::chrono::steady_clock;
+
+        FrameHistory<240> history;
+        Clock::time_point previous_lap { Clock::now() };
+        Clock::time_point previous_step { Clock::now() };
+        Clock::time_point next_present { Clock::now() };
+        f64 accumulator { 0 };
+        f64 alpha { 0 };
+        bool stepped { false };
+        usize late_presents { 0 };
+
+        /// Sleeping is only trusted up to this long before the present time, the rest is spun.
+        static constexpr auto SPIN_MARGIN = std::chrono::microseconds(1500);
+        /// Frame times this close to a whole number of steps are snapped to it.
+        static constexpr f64 SNAP_MILLIS = .5;
+        /// At most this many steps are run in one frame, after a stall the simulation slows down instead.
+        static constexpr f64 MAX_STEPS = 5;
+
+        static auto milliseconds(Clock::duration duration) -> f64 {
+            return std::chrono::duration<f64, std::milli>(duration).count();
+        }
+
+      public:
+        enum CommonRate : u32 {
+            Hz30  = 30,
+            Hz60  = 60,
+            Hz75  = 75,
+            Hz90  = 90,
+            Hz120 = 120,
+            Hz144 = 144,
+            Hz240 = 240,
+            Hz360 = 360,
+        };
+
+        struct Stats final {
+            f64 mean { 0 };
+            f64 p50 { 0 };
+            f64 p95 { 0 };
+            f64 p99 { 0 };
+            f64 max { 0 };
+            /// Presents which were already past their target time when waited for.
+            usize late_presents { 0 };
+        };
+
+        f64 estimated_millis { 0 };
+        u32 estimated_hertz { 0 };
+        std::optional<CommonRate> common_rate;
+
+        /// Marks the start of a frame, recording the time since the previous one.
+        void lap() {
+            const auto now = Clock::now();
+            history.push(milliseconds(now - previous_lap));
+            previous_lap = now;
+
+            estimated_millis = history.mean();
+            estimated_hertz = estimated_millis > 0 ? u32(1000.0 / estimated_millis) : 0;
+
+            common_rate = std::nullopt;
+            for (const auto rate : { Hz30, Hz60, Hz75, Hz90, Hz120, Hz144, Hz240, Hz360 }) {
+                constexpr f64 ERROR = 0.5;
+                if (std::abs(estimated_millis - 1000.0 / f64(rate)) <= ERROR) {
+                    common_rate = rate;
+                    break;
+                }
+            }
+        }
+
+        /// Invokes the update function as many times as fit the time since the previous step at the
+        /// given rate, carrying the remainder over to the next frame. Passing zero as the rate invokes
+        /// it exactly once.
+        ///
+        /// The first step always runs once so there is something to draw.
+        template <typename Fn> void step(u32 rate, Fn update) {
+            const auto now = Clock::now();
+            f64 elapsed = milliseconds(now - previous_step);
+            previous_step = now;
+
+            if (rate == 0 or not stepped) {
+                stepped = true;
+                accumulator = 0;
+                alpha = 1;
+                update();
+                return;
+            }
+
+            const f64 step_millis = 1000.0 / f64(rate);
+            // With vsync frame times jitter around a multiple of the step, without snapping they would
+            // alternate between running zero and two steps.
+            const f64 steps = std::round(elapsed / step_millis);
+            if (steps >= 1 and std::abs(elapsed - steps * step_millis) < SNAP_MILLIS) elapsed = steps * step_millis;
+
+            accumulator = std::min(accumulator + elapsed, step_millis * MAX_STEPS);
+            while (accumulator >= step_millis) {
+                update();
+                accumulator -= step_millis;
+            }
+            alpha = accumulator / step_millis;
+        }
+
+        /// How far past the latest step the current frame is, as a fraction of a step.
+        /// Drawing can interpolate between the previous and latest state by this amount.
+        auto interpolation() const noexcept -> f64 {
+            return alpha;
+        }
+
+        /// Waits until the next present time at the given rate, for when presenting doesn't already wait
+        /// on vsync. When a frame runs over the schedule restarts from now rather than rushing to catch up.
+        void wait_for_present(u32 rate) {
+            if (rate == 0) return;
+
+            const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<f64>(1.0 / f64(rate)));
+            next_present += period;
+
+            auto now = Clock::now();
+            if (next_present <= now) {
+                late_presents += 1;
+                next_present = now;
+                return;
+            }
+
+            // Sleeping can overshoot by a scheduler tick, so it stops short and the rest is spun.
+            if (next_present - now > SPIN_MARGIN) std::this_thread::sleep_for(next_present - now - SPIN_MARGIN);
+            while (Clock::now() < next_present) std::this_thread::yield();
+        }
+
+        auto stats() const -> Stats {
+            return Stats {
+                .mean = history.mean(),
+                .p50 = history.percentile(.5),
+                .p95 = history.percentile(.95),
+                .p99 = history.percentile(.99),
+                .max = history.percentile(1),
+                .late_presents = late_presents,
+            };
+        }
+    };
+
+    /// Returns a concrete type implementing the frame pacing interface.
+    /// The exact type could change in the future.
+    inline auto frame_pacer() {
+        return FramePacer {};
+    }
+}
@@ -0,0 +1,229 @@
+// Asynchronous image sequence output for offline rendering.
+#pragma once
+#include <primitive>
+#include <io>
+#include <draw>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace rt {
+    /// Writes frames out as a numbered image sequence on a background thread.
+    ///
+    /// Submitting a frame only copies it into a bounded queue, encoding and writing happen on the
+    /// writer's own thread, so rendering never waits on the disk. When the disk can't keep up the queue
+    /// fills and frames are either rejected by `push` or wait for a slot in `push_wait`, both of which
+    /// show up in the statistics so back-pressure is visible rather than silently slowing rendering.
+    ///
+    /// Files are named `<directory>/<prefix><frame number>.<extension>`, with the number zero padded
+    /// to six digits. It must not outlive the Io it was created with.
+    class SequenceWriter final {
+      public:
+        struct Stats final {
+            /// Frames accepted into the queue.
+            usize submitted { 0 };
+            /// Frames encoded and written successfully.
+            usize written { 0 };
+            /// Frames rejected by `push` because the queue was full.
+            usize dropped { 0 };
+            /// Frames which could not be written, the Io reported an error.
+            usize failed { 0 };
+            /// Calls to `push_wait` which had to wait for a slot.
+            usize stalls { 0 };
+            /// Total milliseconds spent waiting in `push_wait`.
+            f64 stall_time { 0 };
+            /// Total milliseconds spent encoding and writing on the background thread.
+            f64 encode_time { 0 };
+            f64 write_time { 0 };
+            usize bytes_written { 0 };
+            /// Frames currently queued or being written, and the most there ever were.
+            usize depth { 0 };
+            usize peak_depth { 0 };
+        };
+
+      private:
+        struct Job final {
+            usize number;
+            draw::Image frame;
+        };
+
+        Io& io;
+        std::string directory;
+        std::string prefix;
+        draw::encode::Format format;
+        usize capacity;
+
+        std::mutex lock;
+        std::condition_variable_any wake;
+        std::condition_variable slot_free;
+        std::condition_variable idle;
+        std::deque<Job> queue;
+        /// Slots claimed by producers which are still copying their frame in.
+        usize reserved { 0 };
+        /// Whether the background thread is currently working on a frame taken off the queue.
+        bool busy { false };
+        usize next_number { 0 };
+        Stats counters;
+
+        std::jthread worker;
+
+        static auto milliseconds_since(std::chrono::steady_clock::time_point start) -> f64 {
+            return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        auto path_of(usize number) const -> std::string {
+            char digits[24];
+            std::snprintf(digits, sizeof(digits), "%06llu", (unsigned long long) number);
+            return directory + "/" + prefix + digits + "." + std::string(draw::encode::extension(format));
+        }
+
+        void depth_changed_locked() {
+            counters.depth = queue.size() + reserved + (busy ? 1 : 0);
+            counters.peak_depth = std::max(counters.peak_depth, counters.depth);
+        }
+
+        void run(std::stop_token stop) {
+            while (true) {
+                std::unique_lock guard { lock };
+                wake.wait(guard, stop, [this] { return not queue.empty(); });
+                // Finish whatever was submitted before stopping.
+                if (queue.empty()) return;
+
+                auto job = std::move(queue.front());
+                queue.pop_front();
+                busy = true;
+                guard.unlock();
+
+                const auto encode_start = std::chrono::steady_clock::now();
+                const auto bytes = draw::encode::encode(format, job.frame);
+                const f64 encode_time = milliseconds_since(encode_start);
+
+                const auto write_start = std::chrono::steady_clock::now();
+                bool ok = true;
+                try {
+                    io.write_file(path_of(job.number), bytes);
+                } catch (Io::Error const&) {
+                    ok = false;
+                }
+                const f64 write_time = milliseconds_since(write_start);
+
+                guard.lock();
+                busy = false;
+                counters.encode_time += encode_time;
+                counters.write_time += write_time;
+                if (ok) {
+                    counters.written += 1;
+                    counters.bytes_written += bytes.size();
+                } else {
+                    counters.failed += 1;
+                }
+                depth_changed_locked();
+                slot_free.notify_one();
+                if (queue.empty() and reserved == 0) idle.notify_all();
+            }
+        }
+
+        /// Gives back a reserved slot whose frame never made it into the queue.
+        void release() {
+            std::lock_guard guard { lock };
+            reserved -= 1;
+            depth_changed_locked();
+            slot_free.notify_one();
+            if (queue.empty() and reserved == 0 and not busy) idle.notify_all();
+        }
+
+        /// Copies the frame into a reserved slot, releasing the slot if the copy fails.
+        template <draw::SizedPlane T> void copy_into_slot(T const& frame) {
+            draw::Image copy;
+            try {
+                copy = draw::Image::flatten(frame);
+            } catch (...) {
+                release();
+                throw;
+            }
+            enqueue(std::move(copy));
+        }
+
+        void enqueue(draw::Image frame) {
+            std::lock_guard guard { lock };
+            reserved -= 1;
+            queue.push_back(Job { next_number++, std::move(frame) });
+            counters.submitted += 1;
+            depth_changed_locked();
+            wake.notify_one();
+        }
+
+      public:
+        /// Creates the writer, creating the directory if it doesn't exist yet.
+        ///
+        /// At most `capacity` frames are held in memory at once, including the one being written.
+        SequenceWriter(
+            Io& io [[clang::lifetimebound]],
+            std::string directory,
+            std::string prefix = "frame",
+            draw::encode::Format format = draw::encode::Format::Qoi,
+            usize capacity = 8
+        ) : io(io), directory(std::move(directory)), prefix(std::move(prefix)), format(format), capacity(std::max<usize>(capacity, 1)) {
+            io.create_directory(this->directory);
+            worker = std::jthread([this] (std::stop_token stop) { run(stop); });
+        }
+
+        SequenceWriter(SequenceWriter const&) = delete;
+        auto operator=(SequenceWriter const&) -> SequenceWriter& = delete;
+
+        /// Writes out everything still queued before returning.
+        ~SequenceWriter() {
+            worker.request_stop();
+            worker.join();
+        }
+
+        /// Queues a copy of the frame unless the queue is full, in which case the frame is dropped and
+        /// false returned. Never waits for the disk.
+        template <draw::SizedPlane T> auto push(T const& frame) -> bool {
+            {
+                std::lock_guard guard { lock };
+                if (queue.size() + reserved + (busy ? 1 : 0) >= capacity) {
+                    counters.dropped += 1;
+                    return false;
+                }
+                reserved += 1;
+            }
+            // Copy outside of the lock so producers don't serialize on each other.
+            copy_into_slot(frame);
+            return true;
+        }
+
+        /// Queues a copy of the frame, waiting for a slot if the queue is full.
+        ///
+        /// This does wait on the disk when it can't keep up, use it when no frame may be lost.
+        template <draw::SizedPlane T> void push_wait(T const& frame) {
+            {
+                std::unique_lock guard { lock };
+                if (queue.size() + reserved + (busy ? 1 : 0) >= capacity) {
+                    const auto start = std::chrono::steady_clock::now();
+                    counters.stalls += 1;
+                    slot_free.wait(guard, [this] { return queue.size() + reserved + (busy ? 1 : 0) < capacity; });
+                    counters.stall_time += milliseconds_since(start);
+                }
+                reserved += 1;
+            }
+            copy_into_slot(frame);
+        }
+
+        /// Waits until every frame submitted so far has been written.
+        void flush() {
+            std::unique_lock guard { lock };
+            idle.wait(guard, [this] { return queue.empty() and reserved == 0 and not busy; });
+        }
+
+        auto stats() -> Stats {
+            std::lock_guard guard { lock };
+            return counters;
+        }
+    };
+}
@@ -0,0 +1,219 @@
+// A ring of frames in shared memory for external viewers.
+//
+// The segment starts with a Header, followed by `slot_count` slots of `slot_size` bytes each at
+// `slots_offset`. Every slot begins with a SlotHeader and has its pixels at `pixels_offset` within it,
+// `width * height` RGBA colors in row-major order. All offsets are multiples of 64.
+//
+// Each slot is guarded by a seqlock. The writer makes the sequence odd before touching the slot and even
+// again once it's done, then publishes the slot index in `latest`. A consumer reads `latest`, reads the
+// slot sequence, and if it's even uses the pixels in place before reading the sequence again. If it
+// changed the frame was overwritten meanwhile and has to be discarded. With three or more slots the writer
+// only reaches a slot a consumer is reading if the consumer holds onto it for multiple frames.
+#pragma once
+#include <primitive>
+#include <io>
+#include <draw>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+namespace rt {
+    /// Publishes frames through a shared memory ring which a local viewer maps without any copies.
+    ///
+    /// It can stand in for the window, with `run_headless` rendering straight into shared memory, or run
+    /// alongside it with `run` submitting each frame it draws.
+    class SharedFrameRing final {
+      public:
+        static constexpr u32 MAGIC = 0x42465452; // "RTFB"
+        static constexpr u32 VERSION = 1;
+
+        struct alignas(64) Header final {
+            u32 magic;
+            u32 version;
+            u32 slot_count;
+            i32 width;
+            i32 height;
+            u32 padding;
+            u64 slots_offset;
+            u64 slot_size;
+            u64 pixels_offset;
+            /// The index of the slot holding the newest complete frame plus one, zero before the first frame.
+            alignas(64) std::atomic<u64> latest;
+        };
+
+        struct alignas(64) SlotHeader final {
+            /// Odd while the slot is being written.
+            std::atomic<u64> sequence;
+            /// The number of the frame in the slot, counting from zero.
+            u64 frame;
+        };
+
+        static_assert(std::atomic<u64>::is_always_lock_free, "Shared memory atomics must be lock free");
+        static_assert(std::is_standard_layout_v<Header> and std::is_standard_layout_v<SlotHeader>);
+
+        /// A frame slot being written, a plane over the shared pixels.
+        class Frame final {
+            draw::Color* data;
+            i32 w, h;
+
+            Frame(draw::Color* data, i32 w, i32 h) : data(data), w(w), h(h) {}
+
+            friend class SharedFrameRing;
+
+          public:
+            auto width() const noexcept -> i32 {
+                return w;
+            }
+
+            auto height() const noexcept -> i32 {
+                return h;
+            }
+
+            auto get(i32 x, i32 y) const noexcept -> draw::Color {
+                if (x >= 0 and x < w and y >= 0 and y < h) {
+                    return data[x + y * w];
+                } else {
+                    return draw::color::CLEAR;
+                }
+            }
+
+            void set(i32 x, i32 y, draw::Color color) noexcept {
+                if (x >= 0 and x < w and y >= 0 and y < h) {
+                    data[x + y * w] = color;
+                }
+            }
+
+            auto pixels() const noexcept -> std::span<const draw::Color> {
+                return { data, usize(w) * usize(h) };
+            }
+
+            auto pixels() noexcept -> std::span<draw::Color> {
+                return { data, usize(w) * usize(h) };
+            }
+
+            auto row(i32 y) const noexcept -> std::span<const draw::Color> {
+                return { data + usize(y) * usize(w), usize(w) };
+            }
+
+            auto row(i32 y) noexcept -> std::span<draw::Color> {
+                return { data + usize(y) * usize(w), usize(w) };
+            }
+        };
+
+      private:
+        Io::SharedMemory memory;
+        i32 w, h;
+        u32 slot_count;
+        u64 slot_size;
+        u64 frame_count { 0 };
+
+        static constexpr auto align(u64 value) -> u64 {
+            return (value + 63) & ~u64(63);
+        }
+
+        auto header() const -> Header& {
+            return *(Header*) memory.data();
+        }
+
+        auto slot(u32 index) const -> SlotHeader& {
+            return *(SlotHeader*) (memory.data() + align(sizeof(Header)) + index * slot_size);
+        }
+
+        auto pixels_of(u32 index) const -> draw::Color* {
+            return (draw::Color*) ((u8*) &slot(index) + align(sizeof(SlotHeader)));
+        }
+
+        static auto segment_size(i32 width, i32 height, u32 slots) -> usize {
+            return align(sizeof(Header)) + slots * (align(sizeof(SlotHeader)) + align(usize(width) * height * sizeof(draw::Color)));
+        }
+
+      public:
+        /// Creates the segment under the name, replacing a stale one left behind by a previous run.
+        /// It's removed again when the ring is destroyed, consumers which still have it mapped keep it alive.
+        SharedFrameRing(Io& io [[clang::lifetimebound]], std::string_view name, i32 width, i32 height, u32 slots = 3)
+            : memory(io.create_shared_memory(name, segment_size(width, height, std::max(slots, 2u)))),
+              w(width), h(height), slot_count(std::max(slots, 2u)),
+              slot_size(align(sizeof(SlotHeader)) + align(usize(width) * height * sizeof(draw::Color)))
+        {
+            // The memory is zeroed so constructing the atomics in place is all there is to do.
+            new (memory.data()) Header {
+                .magic = MAGIC,
+                .version = VERSION,
+                .slot_count = slot_count,
+                .width = w,
+                .height = h,
+                .padding = 0,
+                .slots_offset = align(sizeof(Header)),
+                .slot_size = slot_size,
+                .pixels_offset = align(sizeof(SlotHeader)),
+                .latest = 0,
+            };
+            for (u32 i = 0; i < slot_count; i += 1) new (&slot(i)) SlotHeader { 0, 0 };
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+
+        auto width() const noexcept -> i32 {
+            return w;
+        }
+
+        auto height() const noexcept -> i32 {
+            return h;
+        }
+
+        /// Renders a frame directly into the next slot with the provided function of signature:
+        /// (frame: Frame&) -> void
+        ///
+        /// The slot still holds whatever frame was last written to it, the function is expected to
+        /// draw over all of it.
+        template <typename F> void render(F draw) {
+            const u32 index = u32(frame_count % slot_count);
+            auto& guard = slot(index);
+
+            const u64 sequence = guard.sequence.load(std::memory_order_relaxed);
+            guard.sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            auto frame = Frame(pixels_of(index), w, h);
+            draw(frame);
+            guard.frame = frame_count;
+
+            guard.sequence.store(sequence + 2, std::memory_order_release);
+            header().latest.store(index + 1, std::memory_order_release);
+            frame_count += 1;
+        }
+
+        /// Copies a finished frame into the next slot, for use alongside another output like the window.
+        /// Frames of a different size are cropped or padded with clear pixels.
+        template <draw::SizedPlane T> void submit(T const& source) {
+            render([&source] (Frame& frame) {
+                if constexpr (draw::RowPlane<T>) {
+                    const i32 width = std::clamp(source.width(), 0, frame.width());
+                    for (i32 y = 0; y < frame.height(); y += 1) {
+                        const auto out = frame.row(y);
+                        if (y < source.height()) {
+                            const std::span<const draw::Color> in = source.row(y);
+                            std::copy_n(in.begin(), width, out.begin());
+                            std::fill(out.begin() + width, out.end(), draw::color::CLEAR);
+                        } else {
+                            std::fill(out.begin(), out.end(), draw::color::CLEAR);
+                        }
+                    }
+                } else {
+                    for (i32 y = 0; y < frame.height(); y += 1) {
+                        for (i32 x = 0; x < frame.width(); x += 1) frame.set(x, y, source.get(x, y));
+                    }
+                }
+            });
+        }
+
+        /// The number of frames written so far.
+        auto frames() const noexcept -> u64 {
+            return frame_count;
+        }
+    };
+
+    static_assert(draw::MutableRowPlane<SharedFrameRing::Frame>);
+}
@@ -0,0 +1,250 @@
+// Streaming raw video output for piping frames into an external encoder.
+#pragma once
+#include <primitive>
+#include <io>
+#include <draw>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace rt {
+    /// Streams frames to an output as they're finished, typically the standard output or a FIFO read
+    /// by something like ffmpeg, so long renders don't produce thousands of files.
+    ///
+    /// It's double buffered: submitting a frame copies it into a free slot and returns, and a background
+    /// thread converts and writes it while the next frame renders. Submission only waits when both slots
+    /// are still in flight, meaning the consumer of the stream is the bottleneck.
+    ///
+    /// Frames of a different size than the stream are cropped or padded with clear pixels.
+    /// It must not outlive the Io it was created with.
+    class VideoStream final {
+      public:
+        enum class Format {
+            /// YUV4MPEG2 with 4:2:0 chroma subsampling and BT.601 limited range, which encoders accept
+            /// without being told the frame size or rate.
+            Y4m,
+            /// Headerless RGBA bytes, the consumer must be told the size and rate, e.g.
+            /// `ffmpeg -f rawvideo -pixel_format rgba -video_size WxH -framerate N -i -`.
+            Rgba,
+        };
+
+        struct Stats final {
+            usize frames { 0 };
+            /// Frames rejected because the output failed.
+            usize dropped { 0 };
+            /// Total milliseconds spent converting, writing and waiting for a free slot in `submit`.
+            f64 convert_time { 0 };
+            f64 write_time { 0 };
+            f64 wait_time { 0 };
+        };
+
+      private:
+        struct Slot final {
+            draw::Image frame;
+            std::vector<u8> bytes;
+            bool full { false };
+        };
+
+        Io::Output output;
+        Format format;
+        i32 width, height;
+        u32 thread_count;
+
+        std::mutex lock;
+        std::condition_variable_any filled;
+        std::condition_variable emptied;
+        std::array<Slot, 2> slots;
+        usize submitted { 0 };
+        bool broken { false };
+        Stats counters;
+
+        std::jthread worker;
+
+        static auto milliseconds_since(std::chrono::steady_clock::time_point start) -> f64 {
+            return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        static constexpr auto luma(draw::Color c) noexcept -> u8 {
+            return u8(((66 * c.r + 129 * c.g + 25 * c.b + 128) >> 8) + 16);
+        }
+
+        /// Converts the row pairs in the range, the loops are plain integer arithmetic over contiguous
+        /// rows so the compiler vectorizes them.
+        static void convert_rows(
+            draw::Color const* pixels, i32 width, i32 height, i32 pair_begin, i32 pair_end,
+            u8* y_plane, u8* u_plane, u8* v_plane
+        ) noexcept {
+            const i32 chroma_width = (width + 1) / 2;
+
+            for (i32 pair = pair_begin; pair < pair_end; pair += 1) {
+                const i32 y0 = pair * 2;
+                const i32 y1 = std::min(y0 + 1, height - 1);
+                draw::Color const* row0 = pixels + usize(y0) * width;
+                draw::Color const* row1 = pixels + usize(y1) * width;
+
+                for (i32 x = 0; x < width; x += 1) y_plane[usize(y0) * width + x] = luma(row0[x]);
+                if (y1 != y0) for (i32 x = 0; x < width; x += 1) y_plane[usize(y1) * width + x] = luma(row1[x]);
+
+                for (i32 cx = 0; cx < chroma_width; cx += 1) {
+                    const i32 x0 = cx * 2;
+                    const i32 x1 = std::min(x0 + 1, width - 1);
+                    const i32 r = (row0[x0].r + row0[x1].r + row1[x0].r + row1[x1].r + 2) >> 2;
+                    const i32 g = (row0[x0].g + row0[x1].g + row1[x0].g + row1[x1].g + 2) >> 2;
+                    const i32 b = (row0[x0].b + row0[x1].b + row1[x0].b + row1[x1].b + 2) >> 2;
+                    u_plane[usize(pair) * chroma_width + cx] = u8(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+                    v_plane[usize(pair) * chroma_width + cx] = u8(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+                }
+            }
+        }
+
+        /// Returns the bytes to write for the frame in the slot.
+        auto convert(Slot& slot) const -> std::span<const u8> {
+            const auto pixels = slot.frame.pixels();
+
+            // Colors are already laid out as RGBA bytes so raw frames are written as they are.
+            if (format == Format::Rgba) {
+                static_assert(sizeof(draw::Color) == 4);
+                return std::span((u8 const*) pixels.data(), pixels.size() * sizeof(draw::Color));
+            }
+
+            constexpr std::string_view marker = "FRAME\n";
+            const usize luma_size = usize(width) * height;
+            const usize chroma_size = usize((width + 1) / 2) * ((height + 1) / 2);
+            slot.bytes.resize(marker.size() + luma_size + chroma_size * 2);
+
+            std::copy(marker.begin(), marker.end(), slot.bytes.begin());
+            u8* y_plane = slot.bytes.data() + marker.size();
+            u8* u_plane = y_plane + luma_size;
+            u8* v_plane = u_plane + chroma_size;
+
+            const i32 pairs = (height + 1) / 2;
+            const i32 pairs_per_thread = (pairs + i32(thread_count) - 1) / i32(thread_count);
+
+            std::vector<std::jthread> threads;
+            threads.reserve(thread_count);
+            for (u32 t = 0; t < thread_count; t += 1) {
+                const i32 begin = i32(t) * pairs_per_thread;
+                const i32 end = std::min(pairs, begin + pairs_per_thread);
+                if (begin >= end) break;
+                threads.emplace_back([&, begin, end] {
+                    convert_rows(pixels.data(), width, height, begin, end, y_plane, u_plane, v_plane);
+                });
+            }
+            threads.clear(); // Joins them.
+
+            return slot.bytes;
+        }
+
+        void run(std::stop_token stop) {
+            for (usize written = 0;; written += 1) {
+                auto& slot = slots[written % 2];
+                {
+                    std::unique_lock guard { lock };
+                    filled.wait(guard, stop, [&slot] { return slot.full; });
+                    // Finish whatever was submitted before stopping.
+                    if (not slot.full) break;
+                }
+
+                const auto convert_start = std::chrono::steady_clock::now();
+                const auto bytes = convert(slot);
+                const f64 convert_time = milliseconds_since(convert_start);
+
+                const auto write_start = std::chrono::steady_clock::now();
+                bool ok = true;
+                try {
+                    output.write(bytes);
+                } catch (Io::Error const&) {
+                    ok = false;
+                }
+                const f64 write_time = milliseconds_since(write_start);
+
+                std::lock_guard guard { lock };
+                slot.full = false;
+                counters.convert_time += convert_time;
+                counters.write_time += write_time;
+                if (ok) counters.frames += 1;
+                else broken = true;
+                emptied.notify_all();
+            }
+
+            try { output.flush(); } catch (Io::Error const&) {}
+        }
+
+      public:
+        /// Opens the output and writes the stream header, the path "-" streams to the standard output.
+        ///
+        /// Y4M conversion is spread over `threads` threads, by default as many as there are cores.
+        VideoStream(
+            Io& io [[clang::lifetimebound]],
+            std::string_view path,
+            Format format,
+            i32 width,
+            i32 height,
+            u32 fps,
+            u32 threads = std::thread::hardware_concurrency()
+        ) : output(io.open_output(path)), format(format), width(width), height(height), thread_count(std::max(threads, 1u)) {
+            if (format == Format::Y4m) {
+                const auto header = "YUV4MPEG2 W" + std::to_string(width) + " H" + std::to_string(height)
+                                  + " F" + std::to_string(fps) + ":1 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n";
+                output.write(std::span((u8 const*) header.data(), header.size()));
+            }
+            worker = std::jthread([this] (std::stop_token stop) { run(stop); });
+        }
+
+        VideoStream(VideoStream const&) = delete;
+        auto operator=(VideoStream const&) -> VideoStream& = delete;
+
+        /// Writes out the frames still in flight before returning.
+        ~VideoStream() {
+            worker.request_stop();
+            worker.join();
+        }
+
+        /// Submits a finished frame, waiting only if both buffers are still being written.
+        /// Returns false if the output failed, in which case nothing more is written.
+        template <draw::SizedPlane T> auto submit(T const& frame) -> bool {
+            auto& slot = slots[submitted % 2];
+            {
+                std::unique_lock guard { lock };
+                if (broken) {
+                    counters.dropped += 1;
+                    return false;
+                }
+                if (slot.full) {
+                    const auto start = std::chrono::steady_clock::now();
+                    emptied.wait(guard, [&] { return not slot.full or broken; });
+                    counters.wait_time += milliseconds_since(start);
+                    if (broken) {
+                        counters.dropped += 1;
+                        return false;
+                    }
+                }
+            }
+
+            // The slot belongs to us until it's marked full.
+            if (frame.width() == width and frame.height() == height) {
+                slot.frame = draw::Image::flatten(frame);
+            } else {
+                slot.frame = draw::Image(width, height, [&frame] (i32 x, i32 y) { return frame.get(x, y); });
+            }
+
+            std::lock_guard guard { lock };
+            slot.full = true;
+            submitted += 1;
+            filled.notify_one();
+            return true;
+        }
+
+        auto stats() -> Stats {
+            std::lock_guard guard { lock };
+            return counters;
+        }
+    };
+}